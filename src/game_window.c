@@ -3,42 +3,139 @@
 #include "helpers.h"
 #include "game_window.h"
 #include "score_window.h"
+#include "scheduler.h"
 
 static Window *s_window;
 
 static GameState s_game_state;
 static GameStatus s_status;
-static bool s_grid_blocks[GAME_GRID_BLOCK_WIDTH][GAME_GRID_BLOCK_HEIGHT];
-static uint8_t s_grid_colors[GAME_GRID_BLOCK_WIDTH][GAME_GRID_BLOCK_HEIGHT];
+static Grid s_grid;
 
 static Tetromino s_mino_bag[BLOCK_TYPES];
 static Tetromino s_mino_bag_index;
 
 static GPoint next_block[4];
 
-#ifdef CAPABILITY_HELD_BLOCK
-  static GPoint held_block[4];
-#endif
+static int s_ghost_y; // pivot row of the current block once dropped, only changes when it spawns, moves sideways or rotates
+
+static GPoint held_block[4];
 
 static bool s_pause_from_focus = false;
-static bool s_pause_lock_delay = false;
 
-static int s_lines_cleared_at_once = 0;
+static int8_t s_cleared_rows[4]; // rows cleared by the last locked block, top to bottom
+static int s_cleared_rows_count = 0;
+
+// Gravity runs on a fixed step: each step adds the level's gravity to an accumulator (in 1/65536 rows)
+// and the block falls by its whole rows, so it can fall several rows, or all the way (20G), in one step.
+// The timer sleeps until the next whole row is due instead of waking up on every step,
+// and steps are laid on absolute deadlines so the time spent running them doesn't slow gravity down.
+#define GRAVITY_STEP_MS 25
+#define GRAVITY_SHIFT 16
+#define GRAVITY_ONE_ROW (1 << GRAVITY_SHIFT)
+
+// Time for the block to fall one row at each level, 0 = 20G. Past the end of the table, the last entry is used.
+static const uint16_t s_level_row_ms[] = {
+  600, 560, 520, 480, 440, 400, 360, 320, 280, 240, // levels 1 to 10
+  200, 160, 120,  90,  65,  45,  30,  20,  10,   0  // levels 11 to 20
+};
+
+// Everything timed in the game goes through the scheduler, one job slot each
+enum {
+  GameJobGravity,
+  GameJobAutoShift,
+  GameJobLockDelay,
+  GameJobSpawn,
+  GameJobInput,
+  GameJobBackPress,
+  GameJobClock,
+  GameJobFlash
+};
+
+static int32_t s_gravity;       // rows per step, fixed point
+static int32_t s_gravity_acc;   // fraction of row fallen so far, fixed point
+static int s_gravity_steps = 1; // steps the running timer stands for
+static bool s_soft_drop = false; // gravity is multiplied by game_settings.set_soft_drop_factor
+
+// Game clock: s_game_state.time_ms is the time played up to s_clock_start, plus the time since then while it runs.
+// It stops with the game (pause, loss), so it only counts time played.
+static bool s_clock_running = false;
+static uint32_t s_clock_start;
+
+#define SPRINT_LINES 40
+#define ULTRA_MS (2 * 60 * 1000)
+
+// Measured gravity tick periods at the current level, logged when it ends
+typedef struct {
+  uint32_t last_tick;   // scheduler_now() of the last tick, 0 if none since the last report
+  uint32_t ticks;
+  uint32_t period_sum;  // ms between ticks
+  uint32_t target_sum;  // ms the ticks should have taken
+  uint32_t jitter_sum;  // ms away from the target
+} TickStats;
+static TickStats s_tick_stats;
+
+// Auto-shift: holding a move button moves the block once, again after the DAS delay, then every ARR
+// (game_settings). The last button pressed wins, and the other one takes over if it's still held on release.
+static int s_autoshift_direction = 0; // LEFT, RIGHT or 0 if no button is held
+static bool s_autoshift_charged = false; // the DAS delay has elapsed
+static bool s_left_held = false;
+static bool s_right_held = false; // both held = soft drop
+
+// The first button of the UP+DOWN chord has already moved the block: if the other one follows within CHORD_MS,
+// that move is taken back so soft (and chord hard) drops stay in the column.
+#define CHORD_MS 50
+static uint32_t s_shift_press_time = 0; // scheduler_now() of the last move button press
+static int s_shift_press_moved = 0;     // LEFT or RIGHT if that press moved the current block, 0 if not
 
-static AppTimer *s_game_timer = NULL;
-static int s_max_tick = 600;
-static int s_tick_time;
-static int s_tick_interval = 40;
+#ifdef PBL_TOUCH
+  #define DRAG_COLUMN BLOCK_SIZE           // how far the finger goes sideways to move the block a column
+  #define SOFT_DROP_DRAG (BLOCK_SIZE * 2)  // how far the finger goes down before it soft drops
+  #define FLICK_DISTANCE (BLOCK_SIZE * 3)  // a drag down at least this long, and shorter than FLICK_MS, hard drops
+  #define FLICK_MS 250
+
+  static uint32_t s_touchdown_time;
+  static int s_drag_anchor_x;  // finger x when the block last moved with the drag
+  static bool s_drag_moved;    // the drag moved or soft dropped the block
+#endif
 
-static AppTimer *s_longpress_timer = NULL;
-static int s_longpress_tick = 200;
-static int s_longpress_movement_direction;
+// Hard drop on SELECT (game_settings.set_hard_drop): a long press, or a press while soft dropping (UP+DOWN held)
+#define HARD_DROP_HOLD_MS 500
+#define HARD_DROP_QUICK_HOLD_MS 250
+
+static uint32_t s_select_press_time = 0; // scheduler_now() when SELECT last went down, for the press-to-lock log
+
+// Player actions: the input handlers only queue them, and prv_drain_inputs() applies them in order
+// from the GameJobInput job, so they're ordered with gravity and the lock delay by their deadlines.
+// Actions that come in while there's no block wait for the next one, which gives initial rotation and hold,
+// and the ones that come in while paused wait for the game to resume.
+typedef enum {
+  InputMoveLeft,
+  InputMoveRight,
+  InputRotate,
+  InputHardDrop,
+  InputHold,
+  // Auto-shift repeats come after the player's own actions, they don't count in s_game_state.inputs
+  InputRepeatLeft,
+  InputRepeatRight,
+  InputSlideLeft,  // instant repeat (ARR = 0)
+  InputSlideRight,
+  InputUnshift     // takes back the move of the first button of the UP+DOWN chord
+} InputAction;
+
+typedef struct {
+  uint8_t  action; // InputAction
+  uint32_t time;   // scheduler_now() of the press
+} QueuedInput;
+
+#define INPUT_QUEUE_SIZE 8
+static QueuedInput s_input_queue[INPUT_QUEUE_SIZE];
+static uint8_t s_input_head = 0;
+static uint8_t s_input_count = 0;
+static bool s_draining_inputs = false;
 
-static AppTimer *s_lockdelay_timer = NULL;
 static int s_lockdelay_tick = 500;
 static int s_lockdelay_maxmoves = 15;
 
-static AppTimer *s_flash_timer = NULL;
 static int s_flash_tick = 100;
 static int s_flash_amount = 5;
 static GColor s_og_bg_color;
@@ -48,8 +145,25 @@ static char s_score_str[18];
 static char s_level_str[10];
 static char s_lines_str[12];
 
+// The locked stack as last drawn, grid lines included: each frame draws it in one go,
+// and only the rows in s_board_dirty_top..s_board_dirty_bottom are drawn again, then copied back into it.
+// It covers the screen from BOARD_BITMAP_X, with the same pixel format, so rows are copied as they are.
+// Without the memory for it, the whole stack is drawn every frame instead.
+#define BOARD_BITMAP_X PBL_IF_COLOR_ELSE(GRID_ORIGIN_X, GRID_ORIGIN_X / 8 * 8) // 1 bit per pixel: start on a byte
+#define BOARD_BITMAP_W (GRID_ORIGIN_X + GRID_PIXEL_WIDTH + 1 - BOARD_BITMAP_X)
+#define BOARD_BITMAP_H (GRID_PIXEL_HEIGHT + 1)
+static GBitmap *s_board_bitmap = NULL;
+static GBitmap *s_board_view = NULL; // the grid part of it
+static int s_board_dirty_top = 0;
+static int s_board_dirty_bottom = GAME_GRID_BLOCK_HEIGHT - 1;
+
 static Layer     *s_bg_layer = NULL;
-static Layer     *s_game_pane_layer = NULL;
+static Layer     *s_preview_layer = NULL; // next and held blocks
+static int8_t     s_drawn_next_type = NONE;
+static int8_t     s_drawn_held_type = NONE;
+static Layer     *s_game_pane_layer = NULL; // framed around the falling block and its ghost, see prv_refresh_piece()
+static Piece      s_drawn_block = { .type = NONE };
+static int        s_drawn_ghost_y;
 static TextLayer *s_score_layer;
 static TextLayer *s_level_layer;
 static TextLayer *s_lines_layer;
@@ -71,6 +185,8 @@ static void prv_game_window_push();
 static void prv_window_load(Window *window);
 static void prv_window_unload(Window *window);
 static void prv_app_focus_handler(bool focus);
+static void prv_pause_game();
+static void prv_resume_game();
 
 static void prv_click_config_provider(void *context);
 #ifdef PBL_TOUCH
@@ -79,37 +195,72 @@ static void prv_click_config_provider(void *context);
 #endif
 
 static void prv_draw_game(Layer *layer, GContext *ctx);
+static void prv_refresh_piece();
 static void prv_draw_bg(Layer *layer, GContext *ctx);
+static void prv_draw_previews(Layer *layer, GContext *ctx);
+static void prv_refresh_previews();
+static void prv_draw_board_rows(GContext *ctx, int top, int bottom);
+static void prv_store_board_rows(GContext *ctx, int top, int bottom);
+static void prv_invalidate_board(int top, int bottom);
 #ifdef PBL_BW
   static void prv_draw_bw_block(GContext *ctx, GRect rect, uint8_t block_type);
 #endif 
 
+static void prv_queue_input(InputAction action, uint32_t time);
+static void prv_drain_inputs();
+static void prv_apply_input(QueuedInput input);
+static void prv_wake_gravity();
 static void prv_game_cycle();
+static void prv_spawn_block();
+static void prv_schedule_spawn();
 static bool prv_can_drop();
-#ifdef CAPABILITY_HELD_BLOCK
-  static void prv_hold_block();
-#endif
-static void prv_game_move_piece(int movement);
+static void prv_hold_block();
+static void prv_place_block(Tetromino type);
+static bool prv_game_move_piece(int movement);
+static void prv_game_slide_piece(int direction);
+static void prv_autoshift_press(int direction);
+static void prv_autoshift_release(int direction);
+static void prv_autoshift_follow();
 static void prv_game_rotate_piece();
+static void prv_hard_drop(uint32_t pressed_at);
+static void prv_update_ghost();
 static void prv_reset_lock_delay();
 static void prv_lock_piece();
-static void prv_clear_rows();
+static void prv_clear_rows(Piece *piece);
 static void prv_game_lost();
-static void prv_check_top_out(GPoint *block);
-static void prv_check_block_out(GPoint *block);
+static void prv_game_over(char *message);
+static void prv_check_top_out(Piece *piece);
+static void prv_check_block_out(Piece *piece);
 static void prv_refill_mino_bag();
 static Tetromino prv_get_next_piece();
 
+static void prv_update_gravity();
+static void prv_set_soft_drop(bool soft_drop);
+static void prv_schedule_game_tick(uint32_t from);
+static void prv_record_tick(uint32_t now, uint32_t target);
+static void prv_report_tick_stats();
+static void prv_report_session_stats();
+static uint32_t prv_game_time();
+static void prv_clock_start();
+static void prv_clock_stop();
+static void prv_schedule_clock_tick();
+static void prv_clock_tick(void *data);
+static void prv_update_level_label();
 static void prv_game_tick(void *data);
-static void prv_s_longpress_tick(void *data);
+static void prv_autoshift_tick(void *data);
 static void prv_lockdelay_tick(void *data);
+static void prv_spawn_tick(void *data);
+static void prv_input_tick(void *data);
 static void prv_flash_tick(void *data);
 
 static void prv_setup_game();
 static void prv_load_game();
 static void prv_quit_after_loss();
 static void prv_save_game();
+static void prv_load_grid();
 static void prv_migrate_v1_save();
+static void prv_migrate_v2_save();
+static void prv_migrate_v4_save();
 
 // -------------------------- //
 // **** WINDOW FUNCTIONS **** //
@@ -120,9 +271,8 @@ void new_game(){
   prv_game_window_push();
   prv_setup_game();
   prv_game_cycle();
-  if (!s_game_timer) {
-    s_game_timer = app_timer_register(s_tick_time, prv_game_tick, NULL);
-  }
+  prv_schedule_game_tick(scheduler_now());
+  prv_clock_start();
 }
 
 void continue_game(){
@@ -131,9 +281,8 @@ void continue_game(){
   prv_setup_game();
   prv_load_game();
   prv_game_cycle();
-  if (!s_game_timer) {
-    s_game_timer = app_timer_register(s_tick_time, prv_game_tick, NULL);
-  }  
+  prv_schedule_game_tick(scheduler_now());  
+  prv_clock_start();
 }
 
 static void prv_game_window_push() {
@@ -161,11 +310,30 @@ static void prv_window_load(Window *window) {
 
   APP_LOG(APP_LOG_LEVEL_INFO, "GAME WINDOW LOAD");
 
+  s_board_bitmap = gbitmap_create_blank(GSize(BOARD_BITMAP_W, BOARD_BITMAP_H), PBL_IF_COLOR_ELSE(GBitmapFormat8Bit, GBitmapFormat1Bit));
+  if (s_board_bitmap) {
+    s_board_view = gbitmap_create_as_sub_bitmap(s_board_bitmap, GRect(GRID_ORIGIN_X - BOARD_BITMAP_X, 0, GRID_PIXEL_WIDTH + 1, BOARD_BITMAP_H));
+  }
+  if (!s_board_view) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "No memory for the board bitmap, drawing the stack every frame");
+    if (s_board_bitmap) { gbitmap_destroy(s_board_bitmap); }
+    s_board_bitmap = NULL;
+  }
+  s_board_dirty_top = 0;
+  s_board_dirty_bottom = GAME_GRID_BLOCK_HEIGHT - 1;
+
   s_bg_layer = layer_create(GRect(0, 0, bounds_width, bounds_height));
   layer_set_update_proc(s_bg_layer, prv_draw_bg);
   layer_add_child(window_layer, s_bg_layer);
 
-  s_game_pane_layer = layer_create(GRect(GRID_ORIGIN_X, GRID_ORIGIN_Y, GRID_ORIGIN_X+GRID_PIXEL_WIDTH, GRID_ORIGIN_Y+GRID_PIXEL_HEIGHT));
+  s_preview_layer = layer_create(GRect(0, 0, bounds_width, bounds_height));
+  layer_set_update_proc(s_preview_layer, prv_draw_previews);
+  layer_add_child(window_layer, s_preview_layer);
+  s_drawn_next_type = NONE;
+  s_drawn_held_type = NONE;
+
+  s_game_pane_layer = layer_create(GRect(GRID_ORIGIN_X, GRID_ORIGIN_Y, 0, 0));
+  s_drawn_block.type = NONE;
   layer_set_update_proc(s_game_pane_layer, prv_draw_game);
   layer_add_child(window_layer, s_game_pane_layer);
 
@@ -237,10 +405,8 @@ static void prv_window_unload(Window *window) {
     touch_service_unsubscribe();
   #endif
 
-  s_game_timer      = NULL;
-  s_longpress_timer = NULL;
-  s_lockdelay_timer = NULL;
-  s_flash_timer     = NULL;
+  scheduler_cancel_all();
+  prv_clock_stop();
 
   theme.grid_bg_color = s_og_bg_color;
 
@@ -255,7 +421,14 @@ static void prv_window_unload(Window *window) {
   #endif
   
   layer_destroy(s_bg_layer);
+  layer_destroy(s_preview_layer);
   layer_destroy(s_game_pane_layer);
+  s_bg_layer = NULL;
+
+  if (s_board_view) { gbitmap_destroy(s_board_view); }
+  if (s_board_bitmap) { gbitmap_destroy(s_board_bitmap); }
+  s_board_view = NULL;
+  s_board_bitmap = NULL;
 
   #ifdef PBL_BW
     for(int i=0; i<7; i++){
@@ -267,16 +440,14 @@ static void prv_window_unload(Window *window) {
 
 static void prv_app_focus_handler(bool focus) {
   if (!focus) {
+    // Only pause a running game, so it doesn't start again by itself if it was already paused or lost
+    if (s_status != GameStatusPlaying) { return; }
     s_pause_from_focus = true;
-    s_status = GameStatusPaused;
-    Layer *window_layer = window_get_root_layer(s_window);
-    layer_add_child(window_layer, text_layer_get_layer(s_paused_label_layer));
+    prv_pause_game();
   }
   else {
     if (s_pause_from_focus) {
-      s_status = GameStatusPlaying;
-      s_game_timer = app_timer_register(s_tick_time, prv_game_tick, NULL);
-      layer_remove_from_parent(text_layer_get_layer(s_paused_label_layer));
+      prv_resume_game();
     }
     s_pause_from_focus = false;
   }
@@ -295,28 +466,82 @@ static void prv_select_click_handler(ClickRecognizerRef recognizer, void *contex
   
   // Unpause the game if it's paused
   if (s_status == GameStatusPaused) {
-    s_status = GameStatusPlaying;
-    s_game_timer = app_timer_register(s_tick_time, prv_game_tick, NULL);
-    if(s_pause_lock_delay){
-      s_lockdelay_timer = app_timer_register(s_lockdelay_tick, prv_lockdelay_tick, NULL);
-      s_pause_lock_delay = false;
-    }
-    layer_remove_from_parent(text_layer_get_layer(s_paused_label_layer));
+    prv_resume_game();
     return;
   }
 
-  prv_game_rotate_piece();
+  prv_queue_input(InputRotate, scheduler_now());
+}
 
+// The second button of the UP+DOWN chord, see CHORD_MS
+static void prv_chord_unshift() {
+  if (scheduler_now() - s_shift_press_time < CHORD_MS) {
+    prv_queue_input(InputUnshift, scheduler_now());
+  }
 }
 
-static void prv_up_click_handler(ClickRecognizerRef recognizer, void *context) {
-  if (s_status != GameStatusPlaying) { return; }
-  prv_game_move_piece(LEFT);
+// Move buttons use raw press/release events, so the block moves as soon as the button goes down
+// Holding both together soft drops instead of shifting.
+static void prv_up_press_handler(ClickRecognizerRef recognizer, void *context) {
+  s_left_held = true;
+  if (s_right_held) {
+    prv_chord_unshift();
+    prv_autoshift_release(RIGHT);
+    prv_set_soft_drop(true);
+    return;
+  }
+  prv_autoshift_press(LEFT);
+}
+
+static void prv_up_release_handler(ClickRecognizerRef recognizer, void *context) {
+  s_left_held = false;
+  prv_set_soft_drop(false);
+  prv_autoshift_release(LEFT);
+}
+
+static void prv_down_press_handler(ClickRecognizerRef recognizer, void *context) {
+  s_right_held = true;
+  if (s_left_held) {
+    prv_chord_unshift();
+    prv_autoshift_release(LEFT);
+    prv_set_soft_drop(true);
+    return;
+  }
+  prv_autoshift_press(RIGHT);
 }
 
-static void prv_down_click_handler(ClickRecognizerRef recognizer, void *context) {
+static void prv_down_release_handler(ClickRecognizerRef recognizer, void *context) {
+  s_right_held = false;
+  prv_set_soft_drop(false);
+  prv_autoshift_release(RIGHT);
+}
+
+static void prv_pause_game() {
   if (s_status != GameStatusPlaying) { return; }
-  prv_game_move_piece(RIGHT);
+
+  s_status = GameStatusPaused;
+  scheduler_pause(); // every deadline (gravity, lock delay...) is frozen until the game resumes
+  prv_clock_stop();
+  prv_report_tick_stats();
+  prv_report_session_stats();
+  layer_add_child(window_get_root_layer(s_window), text_layer_get_layer(s_paused_label_layer));
+}
+
+static void prv_resume_game() {
+  if (s_status != GameStatusPaused) { return; }
+
+  s_status = GameStatusPlaying;
+  scheduler_resume();
+  prv_clock_start();
+  layer_remove_from_parent(text_layer_get_layer(s_paused_label_layer));
+}
+
+// Hold on BACK (game_settings.set_hold_input), which pauses otherwise: pressed twice within DOUBLE_TAP_MS,
+// the first press only pausing once that's over, or pressed while a move button is down.
+#define DOUBLE_TAP_MS 200
+
+static void prv_back_press_tick(void *data) {
+  prv_pause_game();
 }
 
 static void prv_back_click_handler(ClickRecognizerRef recognizer, void *context) {
@@ -331,118 +556,121 @@ static void prv_back_click_handler(ClickRecognizerRef recognizer, void *context)
       return;
       break;
     default:
-      s_status = GameStatusPaused;
-      if(s_lockdelay_timer){
-        s_pause_lock_delay = true;
-        app_timer_cancel(s_lockdelay_timer);
-        s_lockdelay_timer = NULL;
+      if (game_settings.set_hold_input == HoldInputChord && (s_left_held || s_right_held)) {
+        prv_queue_input(InputHold, scheduler_now());
+        return;
+      }
+      if (game_settings.set_hold_input == HoldInputDoubleBack) {
+        if (scheduler_is_scheduled(GameJobBackPress)) {
+          scheduler_cancel(GameJobBackPress);
+          prv_queue_input(InputHold, scheduler_now());
+        } else {
+          scheduler_schedule(GameJobBackPress, DOUBLE_TAP_MS, prv_back_press_tick, NULL);
+        }
+        return;
       }
-      layer_add_child(window_get_root_layer(s_window), text_layer_get_layer(s_paused_label_layer));
+      prv_pause_game();
     break;
   }
 }
 
 static void prv_select_long_click_handler(ClickRecognizerRef recognizer, void *context) {
-  if(!s_lockdelay_timer) { // check that we're not already locking the piece, or else conflict occurs (no grid color bug)
-    int drop_amount = find_max_drop(s_game_state.block, s_grid_blocks);
-    for (int i=0; i<4; i++) {
-      s_game_state.block[i].y += drop_amount;
-    }
-    prv_lock_piece(); 
-  }
-}
-
-static void prv_down_long_click_handler(ClickRecognizerRef recognizer, void *context) {
-  if (s_status != GameStatusPlaying) { return; }
-  prv_game_move_piece(RIGHT);
-  s_longpress_movement_direction = RIGHT;
-  s_longpress_timer = app_timer_register(s_longpress_tick, prv_s_longpress_tick, NULL);
+  if (s_status != GameStatusPlaying) { return; } // it'd wait in the queue and hard drop as the game resumes
+  prv_queue_input(InputHardDrop, s_select_press_time);
 }
 
-static void prv_down_long_release_handler(ClickRecognizerRef recognizer, void *context) {
-  s_longpress_movement_direction = 0;
-  s_longpress_timer = NULL;
+// Raw SELECT press, only to know when the button went down: the long click comes a whole delay later
+static void prv_select_down_handler(ClickRecognizerRef recognizer, void *context) {
+  s_select_press_time = scheduler_now();
 }
 
-static void prv_up_long_click_handler(ClickRecognizerRef recognizer, void *context) {
-  if (s_status != GameStatusPlaying) { return; }
-  prv_game_move_piece(LEFT);
-  s_longpress_movement_direction = LEFT;
-  s_longpress_timer = app_timer_register(s_longpress_tick, prv_s_longpress_tick, NULL);
-}
-
-static void prv_up_long_release_handler(ClickRecognizerRef recognizer, void *context) {
-  s_longpress_movement_direction = 0;
-  s_longpress_timer = NULL;
+// Chord: SELECT hard drops on press while soft dropping, and rotates as usual otherwise
+static void prv_select_chord_handler(ClickRecognizerRef recognizer, void *context) {
+  if (s_status == GameStatusPlaying && s_left_held && s_right_held) {
+    prv_queue_input(InputHardDrop, scheduler_now());
+    return;
+  }
+  prv_select_click_handler(recognizer, context);
 }
 
 static void prv_click_config_provider(void *context) {
-  window_single_click_subscribe(BUTTON_ID_UP,     prv_up_click_handler);
-  window_single_click_subscribe(BUTTON_ID_DOWN,   prv_down_click_handler);
+  window_raw_click_subscribe(BUTTON_ID_UP,       prv_up_press_handler, prv_up_release_handler, NULL);
+  window_raw_click_subscribe(BUTTON_ID_DOWN,     prv_down_press_handler, prv_down_release_handler, NULL);
   window_single_click_subscribe(BUTTON_ID_BACK,   prv_back_click_handler);
-  window_single_click_subscribe(BUTTON_ID_SELECT, prv_select_click_handler);
 
-  window_long_click_subscribe(BUTTON_ID_SELECT, 500, prv_select_long_click_handler, NULL);
-  window_long_click_subscribe(BUTTON_ID_DOWN, 200, prv_down_long_click_handler, prv_down_long_release_handler);
-  window_long_click_subscribe(BUTTON_ID_UP, 200, prv_up_long_click_handler, prv_up_long_release_handler);
+  if (game_settings.set_hard_drop == HardDropChord) {
+    window_raw_click_subscribe(BUTTON_ID_SELECT, prv_select_chord_handler, NULL, NULL);
+  } else {
+    uint16_t delay = game_settings.set_hard_drop == HardDropQuickHold ? HARD_DROP_QUICK_HOLD_MS : HARD_DROP_HOLD_MS;
+    window_raw_click_subscribe(BUTTON_ID_SELECT, prv_select_down_handler, NULL, NULL);
+    window_single_click_subscribe(BUTTON_ID_SELECT, prv_select_click_handler);
+    window_long_click_subscribe(BUTTON_ID_SELECT, delay, prv_select_long_click_handler, NULL);
+  }
 }
 
 #ifdef PBL_TOUCH
+  // Dragging sideways moves the block a column every DRAG_COLUMN pixels while the finger moves,
+  // dragging down soft drops, and a quick flick down hard drops. A tap holds the block.
   static void touch_handler(const TouchEvent *event, void *context) {
     switch (event->type) {
       case TouchEvent_Touchdown:
-        // TODO: get touchdown position
         touchdown = GPoint(event->x, event->y);
+        s_touchdown_time = scheduler_now();
+        s_drag_anchor_x = event->x;
+        s_drag_moved = false;
         break;
-      case TouchEvent_PositionUpdate:
-        // Nothing here 
+      case TouchEvent_PositionUpdate: {
+        int distance_x = event->x - touchdown.x;
+        int distance_y = event->y - touchdown.y;
+
+        // One column per threshold crossed since the last move, so a fast drag catches up on all of them
+        while (event->x - s_drag_anchor_x >= DRAG_COLUMN) {
+          prv_queue_input(InputMoveRight, scheduler_now());
+          s_drag_anchor_x += DRAG_COLUMN;
+          s_drag_moved = true;
+        }
+        while (s_drag_anchor_x - event->x >= DRAG_COLUMN) {
+          prv_queue_input(InputMoveLeft, scheduler_now());
+          s_drag_anchor_x -= DRAG_COLUMN;
+          s_drag_moved = true;
+        }
+
+        // Dragging down soft drops while the finger stays that far down, and stops once it comes back up
+        if (distance_y > SOFT_DROP_DRAG && distance_y > abs(distance_x)) {
+          prv_set_soft_drop(true);
+          s_drag_moved = true;
+        } else if (distance_y <= SOFT_DROP_DRAG && !(s_left_held && s_right_held)) {
+          prv_set_soft_drop(false);
+        }
         break;
-      case TouchEvent_Liftoff:
-        // TODO: if liftoff is far enough from touchdown within timer
-        //  => move block a bunch instead, in correct direction
+      }
+      case TouchEvent_Liftoff: {
+        int distance_x = event->x - touchdown.x;
+        int distance_y = event->y - touchdown.y;
+        prv_set_soft_drop(false);
 
-        if(s_game_state.block_type == NONE) { return; }
         if(s_status != GameStatusPlaying)   { return; }
-        // if(s_lockdelay_timer)               { return; }
-
-        // HARD MOVE 
-        if (touchdown.x != 0) {
-          int distance_x = event->x - touchdown.x;
-          int distance_y = event->y - touchdown.y;
-
-          int direction = 0;
-
-          if(distance_x > PBL_DISPLAY_WIDTH * 0.3) {
-            direction = RIGHT;            
-          } else if(abs(distance_x) > PBL_DISPLAY_WIDTH * 0.3) {
-            direction = LEFT;            
-          } 
-          
-          if(direction != 0) {
-            int move_amount = find_max_horiz_move(s_game_state.block, s_grid_blocks, direction);
-            for (int i=0; i<4; i++) {
-              s_game_state.block[i].x += move_amount * direction;
-            }
-            return;
-          } else if (distance_y > PBL_DISPLAY_WIDTH * 0.3) {
-            int drop_amount = find_max_drop(s_game_state.block, s_grid_blocks);
-            for (int i=0; i<4; i++) {
-              s_game_state.block[i].y += drop_amount;
-            }
-            return;
-          }
 
+        // HARD DROP
+        bool quick = scheduler_now() - s_touchdown_time < FLICK_MS;
+        if (quick && distance_y > FLICK_DISTANCE && distance_y > abs(distance_x)) {
+          prv_queue_input(InputHardDrop, scheduler_now());
+          return;
         }
 
+        // The drag already did its job, it's not a tap
+        if (s_drag_moved) { return; }
+
         // HOLD BLOCK
 
         // Edge rejection
         if(event->x < TOUCH_MARGIN || event->x > PBL_DISPLAY_WIDTH - TOUCH_MARGIN) { return; }
         if(event->y < TOUCH_MARGIN || event->y > PBL_DISPLAY_HEIGHT - TOUCH_MARGIN) { return; }
 
-        prv_hold_block();
+        prv_queue_input(InputHold, scheduler_now());
 
         break;
+      }
     }
   }
 #endif
@@ -454,22 +682,28 @@ static void prv_click_config_provider(void *context) {
 // Draw current block and its shadow in game area
 static void prv_draw_game(Layer *layer, GContext *ctx) {
 
-  if (s_status != GameStatusPlaying || s_game_state.block_type == NONE) { return; }
+  if (s_status != GameStatusPlaying || s_game_state.block.type == NONE) { return; }
 
-  GPoint *block = s_game_state.block;
+  GPoint block[4];
+  piece_get_cells(&s_game_state.block, block);
+
+  // The layer only covers the block and its ghost, draw relative to it
+  GRect frame = layer_get_frame(layer);
+  int origin_x = GRID_ORIGIN_X - frame.origin.x;
+  int origin_y = GRID_ORIGIN_Y - frame.origin.y;
 
   // Fast-drop is instant, so we need to show a guide.
   if(game_settings.set_drop_shadow) { 
     #ifdef PBL_COLOR
       graphics_context_set_fill_color(ctx, theme.drop_shadow_color);
     #endif
-    int max_drop = find_max_drop(block, s_grid_blocks);
+    int max_drop = s_ghost_y - s_game_state.block.y;
       for (int i=0; i<4; i++) {
         #ifdef PBL_COLOR
-          GRect brick_ghost = GRect(block[i].x * BLOCK_SIZE, (block[i].y + max_drop)*BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE);
+          GRect brick_ghost = GRect(origin_x + block[i].x * BLOCK_SIZE, origin_y + (block[i].y + max_drop)*BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE);
           graphics_fill_rect(ctx, brick_ghost, 0, GCornerNone);
         #else
-          GRect brick_ghost = GRect(block[i].x * BLOCK_SIZE +1, (block[i].y + max_drop)*BLOCK_SIZE+1, BLOCK_SIZE-1, BLOCK_SIZE-1);
+          GRect brick_ghost = GRect(origin_x + block[i].x * BLOCK_SIZE +1, origin_y + (block[i].y + max_drop)*BLOCK_SIZE+1, BLOCK_SIZE-1, BLOCK_SIZE-1);
           graphics_draw_bitmap_in_rect(ctx, s_bw_shadow_sprite, brick_ghost);
       #endif
     }
@@ -478,22 +712,55 @@ static void prv_draw_game(Layer *layer, GContext *ctx) {
   // Draw the actual block.
   #ifdef PBL_COLOR
     graphics_context_set_stroke_color(ctx, theme.block_border_color);
-    graphics_context_set_fill_color(ctx, theme.block_color[s_game_state.block_type]);
+    graphics_context_set_fill_color(ctx, theme.block_color[s_game_state.block.type]);
   #else
     graphics_context_set_stroke_color(ctx, GColorBlack);
   #endif
 
   for (int i=0; i<4; i++) {
-    GRect brick = GRect(block[i].x * BLOCK_SIZE, block[i].y * BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE);
+    GRect brick = GRect(origin_x + block[i].x * BLOCK_SIZE, origin_y + block[i].y * BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE);
     #ifdef PBL_COLOR
       graphics_fill_rect(ctx, brick, 0, GCornerNone);
       graphics_draw_rect(ctx, brick);
     #else
-      prv_draw_bw_block(ctx, brick, s_game_state.block_type);
+      prv_draw_bw_block(ctx, brick, s_game_state.block.type);
     #endif
   }
 }
 
+// Redraw the falling block only if it or its ghost moved, with the game pane framed tightly around both.
+// Pebble repaints the whole window on any dirty layer, but this skips the frames where nothing moved
+// (gravity ticks while the block rests, moves into a wall) and keeps the pane's drawing to a few cells.
+static void prv_refresh_piece() {
+  Piece *block = &s_game_state.block;
+  if (block->type == s_drawn_block.type && block->rotation == s_drawn_block.rotation &&
+      block->x == s_drawn_block.x && block->y == s_drawn_block.y && s_ghost_y == s_drawn_ghost_y) { return; }
+  s_drawn_block = *block;
+  s_drawn_ghost_y = s_ghost_y;
+
+  GRect frame = GRect(GRID_ORIGIN_X, GRID_ORIGIN_Y, 0, 0);
+  if (block->type != NONE) {
+    GPoint cells[4];
+    piece_get_cells(block, cells);
+    int bottom_offset = game_settings.set_drop_shadow ? s_ghost_y - block->y : 0;
+    int left = GAME_GRID_BLOCK_WIDTH, right = -1, top = GAME_GRID_BLOCK_HEIGHT, bottom = -1;
+    for (int i=0; i<4; i++) {
+      if (cells[i].x < left) { left = cells[i].x; }
+      if (cells[i].x > right) { right = cells[i].x; }
+      if (cells[i].y < top) { top = cells[i].y; }
+      if (cells[i].y + bottom_offset > bottom) { bottom = cells[i].y + bottom_offset; }
+    }
+    if (top < 0) { top = 0; } // the buffer rows are hidden
+    if (bottom >= top) {
+      frame = GRect(GRID_ORIGIN_X + left * BLOCK_SIZE, GRID_ORIGIN_Y + top * BLOCK_SIZE,
+                    (right - left + 1) * BLOCK_SIZE + 1, (bottom - top + 1) * BLOCK_SIZE + 1);
+    }
+  }
+
+  layer_set_frame(s_game_pane_layer, frame);
+  layer_mark_dirty(s_game_pane_layer);
+}
+
 // Draw rest of game board: bg, board with grid, previous blocks
 static void prv_draw_bg(Layer *layer, GContext *ctx) {
 
@@ -507,31 +774,30 @@ static void prv_draw_bg(Layer *layer, GContext *ctx) {
   GRect color_bg = GRect(0, 0, bounds_width, bounds_height);
   graphics_fill_rect(ctx, color_bg, 0, GCornerNone);
 
-  // Game BG.
-  #ifdef PBL_COLOR
-    graphics_context_set_fill_color(ctx, theme.grid_bg_color);
-  #else
-    graphics_context_set_fill_color(ctx, GColorWhite);
+  // Locked stack, from the board bitmap with the rows that changed since the last frame drawn again
+  #ifdef PBL_BW
     graphics_context_set_stroke_color(ctx, GColorBlack);
   #endif
 
-  GRect game_bg = GRect(GRID_ORIGIN_X, GRID_ORIGIN_Y, GRID_PIXEL_WIDTH, GRID_PIXEL_HEIGHT);
-  graphics_fill_rect(ctx, game_bg, 0, GCornerNone);
+  if (!s_board_view) {
+    prv_draw_board_rows(ctx, 0, GAME_GRID_BLOCK_HEIGHT - 1);
+    return;
+  }
 
-  // Grid colors from leftover blocks.
-  for (int i=0; i<GAME_GRID_BLOCK_WIDTH; i++) {
-    for (int j=0; j<GAME_GRID_BLOCK_HEIGHT; j++) {
-      if (s_grid_colors[i][j] != 255) {
-        GRect brick = GRect((i*BLOCK_SIZE) + GRID_ORIGIN_X, (j*BLOCK_SIZE) + GRID_ORIGIN_Y, BLOCK_SIZE, BLOCK_SIZE);
-        #ifdef PBL_COLOR
-          graphics_context_set_fill_color(ctx, theme.block_color[s_grid_colors[i][j]]);
-          graphics_fill_rect(ctx, brick, 0, GCornerNone);
-        #else
-          prv_draw_bw_block(ctx, brick, s_grid_colors[i][j]);
-        #endif
-      }
-    }
+  graphics_draw_bitmap_in_rect(ctx, s_board_view, GRect(GRID_ORIGIN_X, GRID_ORIGIN_Y, GRID_PIXEL_WIDTH + 1, GRID_PIXEL_HEIGHT + 1));
+  if (s_board_dirty_top <= s_board_dirty_bottom) {
+    prv_draw_board_rows(ctx, s_board_dirty_top, s_board_dirty_bottom);
+    prv_store_board_rows(ctx, s_board_dirty_top, s_board_dirty_bottom);
+    s_board_dirty_top = GAME_GRID_BLOCK_HEIGHT;
+    s_board_dirty_bottom = -1;
   }
+}
+
+// Next and held blocks, only drawn again when one of them changes, see prv_refresh_previews()
+static void prv_draw_previews(Layer *layer, GContext *ctx) {
+  #ifdef PBL_BW
+    graphics_context_set_stroke_color(ctx, GColorBlack);
+  #endif
 
   // NEXT BLOCK
 
@@ -568,46 +834,149 @@ static void prv_draw_bg(Layer *layer, GContext *ctx) {
 
   // HELD BLOCK
   
-  #ifdef CAPABILITY_HELD_BLOCK
+  if(s_game_state.held_block_type != NONE) {
     #ifdef PBL_COLOR
       graphics_context_set_fill_color(ctx, theme.block_color[s_game_state.held_block_type]);
     #endif
 
-    if(s_game_state.held_block_type != NONE) {
-      #if defined(PBL_ROUND)
-        sPosX = HELD_BLOCK_X + next_block_offset(s_game_state.held_block_type);
-        sPosY = NEXT_BLOCK_Y;
+    #if defined(PBL_ROUND)
+      sPosX = HELD_BLOCK_X + next_block_offset(s_game_state.held_block_type);
+      sPosY = HELD_BLOCK_Y;
+    #else
+      sPosX = HELD_BLOCK_X + next_block_offset(s_game_state.held_block_type);
+      sPosY = HELD_BLOCK_Y + BLOCK_SIZE * (s_game_state.held_block_type == I ? 0 : 0.5);
+    #endif
+
+    #ifdef PBL_BW
+      // BG for held block view, in the gap under the lines label
+      graphics_context_set_fill_color(ctx, GColorWhite);
+      graphics_fill_rect(ctx, GRect(LABEL_X, LABEL_LINES_Y + BLOCK_SIZE * 4, LABEL_WIDTH, GRID_PIXEL_HEIGHT + GRID_ORIGIN_Y - (LABEL_LINES_Y + BLOCK_SIZE * 4)), 0, GCornerNone);
+    #endif
+
+    for (int i=0; i<4; i++) {
+      GRect bl = GRect(sPosX+(held_block[i].x * BLOCK_SIZE), sPosY+(held_block[i].y * BLOCK_SIZE), BLOCK_SIZE, BLOCK_SIZE);
+      #ifdef PBL_COLOR
+        graphics_fill_rect(ctx, bl, 0, GCornerNone);
+        graphics_draw_rect(ctx, bl);
       #else
-        sPosX = NEXT_BLOCK_X + next_block_offset(s_game_state.held_block_type);
-        sPosY = NEXT_BLOCK_Y + BLOCK_SIZE*4.5 + BLOCK_SIZE * (s_game_state.held_block_type == I ? 0 : 0.5);
+        prv_draw_bw_block(ctx, bl, s_game_state.held_block_type);
       #endif
-
-      for (int i=0; i<4; i++) {
-        GRect bl = GRect(sPosX+(held_block[i].x * BLOCK_SIZE), sPosY+(held_block[i].y * BLOCK_SIZE), BLOCK_SIZE, BLOCK_SIZE);
-        #ifdef PBL_COLOR
-          graphics_fill_rect(ctx, bl, 0, GCornerNone);
-          graphics_draw_rect(ctx, bl);
-        #else
-          prv_draw_bw_block(ctx, bl, s_game_state.held_block_type);
-        #endif
-      }
     }
+  }
+}
+
+// Mark the previews dirty if the next or held block isn't the one they show
+static void prv_refresh_previews() {
+  if (s_game_state.next_block_type == s_drawn_next_type && s_game_state.held_block_type == s_drawn_held_type) { return; }
+  s_drawn_next_type = s_game_state.next_block_type;
+  s_drawn_held_type = s_game_state.held_block_type;
+  layer_mark_dirty(s_preview_layer);
+}
+
+// Draw the rows of the locked stack from top to bottom, grid lines included, over their background.
+#ifdef PBL_BW
+  // Cells are outlined on the first pixel line of the cells below and right, so the row above is drawn again
+  // over what its outlines share with the top row, and the row below is drawn too, over the outlines of the bottom row.
+#endif
+static void prv_draw_board_rows(GContext *ctx, int top, int bottom) {
+  #ifdef PBL_BW
+    if (bottom < GAME_GRID_BLOCK_HEIGHT - 1) { bottom++; }
   #endif
 
-  // Game BG grid.
+  GRect rows = GRect(GRID_ORIGIN_X, GRID_ORIGIN_Y + top * BLOCK_SIZE, GRID_PIXEL_WIDTH, (bottom - top + 1) * BLOCK_SIZE);
+  graphics_context_set_fill_color(ctx, PBL_IF_COLOR_ELSE(theme.grid_bg_color, GColorWhite));
+  graphics_fill_rect(ctx, rows, 0, GCornerNone);
+
+  int first_row = top;
+  #ifdef PBL_BW
+    if (first_row > 0) { first_row--; }
+  #else
+    uint8_t fill_cell = GRID_CELL_EMPTY; // block type of the fill color set, to skip setting it again
+  #endif
+
+  for (int j=first_row; j<=bottom; j++) {
+    if (GRID_ROW(&s_grid, j) == GRID_ROW_EMPTY) { continue; }
+
+    uint8_t *row_colors = GRID_ROW_COLORS(&s_grid, j);
+    #ifdef PBL_COLOR
+      // Cells of the same color side by side are filled as one rect, the grid lines split them up afterwards
+      for (int i=0; i<GAME_GRID_BLOCK_WIDTH; ) {
+        uint8_t cell = row_colors[i];
+        int run = 1;
+        while (i + run < GAME_GRID_BLOCK_WIDTH && row_colors[i + run] == cell) { run++; }
+
+        if (cell != GRID_CELL_EMPTY) {
+          if (cell != fill_cell) {
+            graphics_context_set_fill_color(ctx, theme.block_color[cell]);
+            fill_cell = cell;
+          }
+          graphics_fill_rect(ctx, GRect((i*BLOCK_SIZE) + GRID_ORIGIN_X, (j*BLOCK_SIZE) + GRID_ORIGIN_Y, run * BLOCK_SIZE, BLOCK_SIZE), 0, GCornerNone);
+        }
+        i += run;
+      }
+    #else
+      // Each cell has its own outline and sprite
+      for (int i=0; i<GAME_GRID_BLOCK_WIDTH; i++) {
+        if (row_colors[i] != GRID_CELL_EMPTY) {
+          GRect brick = GRect((i*BLOCK_SIZE) + GRID_ORIGIN_X, (j*BLOCK_SIZE) + GRID_ORIGIN_Y, BLOCK_SIZE, BLOCK_SIZE);
+          prv_draw_bw_block(ctx, brick, row_colors[i]);
+        }
+      }
+    #endif
+  }
+
   #ifdef PBL_COLOR
-    graphics_context_set_stroke_color(ctx, theme.grid_lines_color);
-    // Draw vertical lines
-    for (int i=GRID_ORIGIN_X; i<=(GRID_PIXEL_WIDTH+GRID_ORIGIN_X); i+=BLOCK_SIZE) {
-      graphics_draw_line(ctx, GPoint(i, GRID_ORIGIN_Y), GPoint(i, GRID_ORIGIN_Y + GRID_PIXEL_HEIGHT)); 
-    }
-    // Draw horizontal lines
-    for (int i=GRID_ORIGIN_Y; i<=(GRID_PIXEL_HEIGHT+GRID_ORIGIN_Y); i+=BLOCK_SIZE) {
-      graphics_draw_line(ctx, GPoint(GRID_ORIGIN_X, i), GPoint(GRID_ORIGIN_X+GRID_PIXEL_WIDTH, i));
-    }
+    // Grid lines over the cells, up to the first line of the row below, or the bottom edge
+    grid_lines_draw(&theme_grid_lines, ctx, GRect(rows.origin.x, rows.origin.y, rows.size.w + 1, rows.size.h + 1), GPoint(0, 0));
   #endif
 }
 
+// Copy the rows from the screen into the board bitmap, along with the pixel line they share with the row below
+static void prv_store_board_rows(GContext *ctx, int top, int bottom) {
+  #ifdef PBL_BW
+    if (bottom < GAME_GRID_BLOCK_HEIGHT - 1) { bottom++; } // drawn by prv_draw_board_rows() too
+  #endif
+
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (!frame_buffer) { return; }
+
+  #ifdef PBL_BW
+    uint8_t *screen_data = gbitmap_get_data(frame_buffer);
+    uint16_t screen_stride = gbitmap_get_bytes_per_row(frame_buffer);
+    uint8_t *board_data = gbitmap_get_data(s_board_bitmap);
+    uint16_t board_stride = gbitmap_get_bytes_per_row(s_board_bitmap);
+  #endif
+
+  for (int y=top * BLOCK_SIZE; y<=(bottom + 1) * BLOCK_SIZE; y++) {
+    #ifdef PBL_COLOR
+      GBitmapDataRowInfo screen_row = gbitmap_get_data_row_info(frame_buffer, GRID_ORIGIN_Y + y);
+      GBitmapDataRowInfo board_row = gbitmap_get_data_row_info(s_board_bitmap, y);
+      // one byte per pixel, round screens only have the pixels from min_x to max_x on each row
+      int min_x = screen_row.min_x > BOARD_BITMAP_X ? screen_row.min_x : BOARD_BITMAP_X;
+      int max_x = screen_row.max_x < BOARD_BITMAP_X + BOARD_BITMAP_W - 1 ? screen_row.max_x : BOARD_BITMAP_X + BOARD_BITMAP_W - 1;
+      if (max_x >= min_x) {
+        memcpy(board_row.data + (min_x - BOARD_BITMAP_X), screen_row.data + min_x, max_x - min_x + 1);
+      }
+    #else
+      // one bit per pixel, the bitmap starts on a byte of the screen row so the bits line up
+      memcpy(board_data + y * board_stride, screen_data + (GRID_ORIGIN_Y + y) * screen_stride + BOARD_BITMAP_X / 8, (BOARD_BITMAP_W + 7) / 8);
+    #endif
+  }
+
+  graphics_release_frame_buffer(ctx, frame_buffer);
+}
+
+// Draw these visible rows of the locked stack again on the next frame
+static void prv_invalidate_board(int top, int bottom) {
+  if (top < 0) { top = 0; }
+  if (bottom > GAME_GRID_BLOCK_HEIGHT - 1) { bottom = GAME_GRID_BLOCK_HEIGHT - 1; }
+  if (top > bottom) { return; }
+
+  if (top < s_board_dirty_top) { s_board_dirty_top = top; }
+  if (bottom > s_board_dirty_bottom) { s_board_dirty_bottom = bottom; }
+  if (s_bg_layer) { layer_mark_dirty(s_bg_layer); }
+}
+
 #ifdef PBL_BW
   static void prv_draw_bw_block(GContext *ctx, GRect rect, uint8_t block_type) {
     graphics_draw_rect(ctx, GRect(rect.origin.x, rect.origin.y, rect.size.w + 1, rect.size.h + 1));
@@ -619,158 +988,302 @@ static void prv_draw_bg(Layer *layer, GContext *ctx) {
 // **** GAME FUNCTIONS **** //
 // ------------------------ //
 
-static void prv_game_cycle() {
-  if (s_game_state.block_type == NONE) {
-    // Create a new block.
-    s_game_state.rotation = 0;
-    s_game_state.block_type = s_game_state.next_block_type;
-    s_game_state.next_block_type = prv_get_next_piece();
-    s_game_state.can_hold_block = true;
+static void prv_queue_input(InputAction action, uint32_t time) {
+  if (s_status == GameStatusLost) { return; }
+
+  // Mashing faster than the game runs: apply what's waiting now to make room, if there's a block to apply it to
+  if (s_input_count == INPUT_QUEUE_SIZE && s_status == GameStatusPlaying) { prv_drain_inputs(); }
+  if (s_input_count == INPUT_QUEUE_SIZE) {
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Input queue full, dropped action %d", action);
+    return;
+  }
+
+  s_input_queue[(s_input_head + s_input_count) % INPUT_QUEUE_SIZE] = (QueuedInput) { .action = action, .time = time };
+  if (action < InputRepeatLeft && s_game_state.inputs < UINT16_MAX) { s_game_state.inputs++; }
+  s_input_count++;
+  if (!scheduler_is_scheduled(GameJobInput)) {
+    scheduler_schedule(GameJobInput, 0, prv_input_tick, NULL);
+  }
+}
+
+// Apply the queued actions to the block, or leave them for the next block if there's none
+static void prv_drain_inputs() {
+  if (s_draining_inputs) { return; } // a hard drop spawned the next block, the running loop goes on with it
+  s_draining_inputs = true;
 
-    GPoint new_block_pos = s_game_state.block_type == I ? GPoint(4, 0) : GPoint(5, 1);
+  while (s_input_count > 0 && s_status == GameStatusPlaying && s_game_state.block.type != NONE) {
+    QueuedInput input = s_input_queue[s_input_head];
+    s_input_head = (s_input_head + 1) % INPUT_QUEUE_SIZE;
+    s_input_count--;
+    prv_apply_input(input);
+  }
 
-    make_block(s_game_state.block, s_game_state.block_type, new_block_pos.x, new_block_pos.y);
+  s_draining_inputs = false;
+  prv_wake_gravity();
+}
 
-    prv_check_block_out(s_game_state.block);
+// Gravity stops while the block rests on the stack, and starts again once a move, rotation or hold frees it
+static void prv_wake_gravity() {
+  if (s_status != GameStatusPlaying || s_game_state.block.type == NONE) { return; }
+  if (scheduler_is_scheduled(GameJobGravity) || !prv_can_drop()) { return; }
 
-    make_block(next_block, s_game_state.next_block_type, 0, 0);
+  s_gravity_acc = 0;
+  s_tick_stats.last_tick = 0; // the time spent resting isn't a tick period
+  prv_schedule_game_tick(scheduler_now());
+}
+
+static void prv_apply_input(QueuedInput input) {
+  switch (input.action) {
+    case InputMoveLeft:    s_shift_press_moved = prv_game_move_piece(LEFT) ? LEFT : 0;   break;
+    case InputMoveRight:   s_shift_press_moved = prv_game_move_piece(RIGHT) ? RIGHT : 0; break;
+    case InputRepeatLeft:  prv_game_move_piece(LEFT);   break;
+    case InputRepeatRight: prv_game_move_piece(RIGHT);  break;
+    case InputUnshift:
+      if (s_shift_press_moved != 0) { prv_game_move_piece(-s_shift_press_moved); }
+      s_shift_press_moved = 0;
+      break;
+    case InputSlideLeft:   prv_game_slide_piece(LEFT);  break;
+    case InputSlideRight:  prv_game_slide_piece(RIGHT); break;
+    case InputRotate:      prv_game_rotate_piece();     break;
+    case InputHardDrop:
+      prv_hard_drop(input.time);
+      break;
+    case InputHold:
+      prv_hold_block();
+      break;
+    default: break;
+  }
+}
+
+static void prv_game_cycle() {
+  if (s_game_state.block.type == NONE) {
+    // Create a new block (when the game starts, later blocks spawn as soon as the previous one locks).
+    prv_spawn_block();
   }
   else {
     // Handle the current block.
-    // Drop it, and if it can't drop then stick it in place and make a new block.
-
-    GPoint *block = s_game_state.block;
-
-    if (prv_can_drop()) {
-      if(s_lockdelay_timer){
-        app_timer_cancel(s_lockdelay_timer);
-        s_lockdelay_timer = NULL;
-        s_lockdelay_maxmoves = 15;
-      }
-      for (int i=0; i<4; i++) {
-        block[i].y += 1;
+    // Drop it by the whole rows of gravity accumulated, and if it can't drop then stick it in place and make a new block.
+    int rows = s_gravity_acc >> GRAVITY_SHIFT;
+    s_gravity_acc &= GRAVITY_ONE_ROW - 1;
+
+    if (!prv_can_drop()) {
+      // Gravity doesn't build up while the block rests on the stack
+      s_gravity_acc = 0;
+      if(!scheduler_is_scheduled(GameJobLockDelay)){
+        scheduler_schedule(GameJobLockDelay, s_lockdelay_tick, prv_lockdelay_tick, NULL);
       }
     }
-    else {
-      if(!s_lockdelay_timer){
-        s_lockdelay_timer = app_timer_register(s_lockdelay_tick, prv_lockdelay_tick, NULL);
+    else if (rows > 0) {
+      if(scheduler_is_scheduled(GameJobLockDelay)){
+        scheduler_cancel(GameJobLockDelay);
+        s_lockdelay_maxmoves = 15;
+      }
+      int max_drop = s_ghost_y - s_game_state.block.y;
+      int drop = (rows < max_drop) ? rows : max_drop;
+      s_game_state.block.y += drop;
+
+      // Soft dropped rows score a point each
+      if (s_soft_drop && drop > 0) {
+        s_game_state.score += drop;
+        if (s_game_state.score >= 999999)
+          s_game_state.score = 999999;
+        update_string_num_layer("SCORE\n", s_game_state.score, s_score_str, sizeof(s_score_str), s_score_layer);
       }
     }
   }
 
-  layer_mark_dirty(s_game_pane_layer);
+  prv_refresh_piece();
 }
 
-static bool prv_can_drop(){
-  GPoint *block = s_game_state.block;
+static void prv_spawn_block() {
+  prv_place_block(s_game_state.next_block_type);
+  s_game_state.next_block_type = prv_get_next_piece();
+  s_game_state.can_hold_block = true;
+  s_gravity_acc = 0;
 
-  bool can_drop = true;
-  for (int i=0; i<4; i++) {
-    int dropped_block_Y = block[i].y + 1;
-    if (dropped_block_Y > 19) { can_drop = false; }
-    if (s_grid_blocks[block[i].x][block[i].y]) { can_drop = false; }
-    if (s_grid_blocks[block[i].x][dropped_block_Y]) { can_drop = false; }
+  prv_check_block_out(&s_game_state.block);
+
+  make_block(next_block, s_game_state.next_block_type, 0, 0);
+  prv_refresh_previews();
+
+  // Actions queued since the last block locked apply before it's drawn (initial rotation, initial hold)
+  prv_drain_inputs();
+}
+
+// Bring in the next block once the entry delay, plus the line clear delay if the last block cleared rows,
+// has passed: right away by default, instead of waiting for the next gravity tick.
+static void prv_schedule_spawn() {
+  if (s_status != GameStatusPlaying || s_game_state.block.type != NONE) { return; }
+
+  scheduler_cancel(GameJobGravity); // gravity starts over with the new block
+
+  uint32_t delay = game_settings.set_entry_delay;
+  if (s_cleared_rows_count > 0) { delay += game_settings.set_line_clear_delay; }
+  if (delay == 0) {
+    prv_spawn_tick(NULL);
+    return;
   }
+  scheduler_schedule(GameJobSpawn, delay, prv_spawn_tick, NULL);
+}
+
+static bool prv_can_drop(){
+  Piece *piece = &s_game_state.block;
 
-  return can_drop;
+  if (grid_collides(piece, 0, 0, &s_grid)) { return false; }
+  return !grid_collides(piece, 0, 1, &s_grid);
 }
 
-#ifdef CAPABILITY_HELD_BLOCK
 static void prv_hold_block(){
   if(!s_game_state.can_hold_block)    { return; }
+  if(s_game_state.block.type == NONE) { return; }
 
   int buffer = s_game_state.held_block_type;
   
-  s_game_state.held_block_type = s_game_state.block_type;
-  s_game_state.block_type = buffer;
+  s_game_state.held_block_type = s_game_state.block.type;
   
   s_game_state.can_hold_block = false;
   
   make_block(held_block, s_game_state.held_block_type, 0, 0);
 
-  if(s_game_state.block_type != NONE) { 
-    GPoint new_block_pos = s_game_state.block_type == I ? GPoint(4, 0) : GPoint(5, 1);
-
-    make_block(s_game_state.block, s_game_state.block_type, new_block_pos.x, new_block_pos.y);
-
+  if(buffer != NONE) { 
+    prv_place_block(buffer);
   } else {
     // Same as game_cycle(): block == NONE, but we don't reset s_game_state.can_hold_block
-    s_game_state.rotation = 0;
-    s_game_state.block_type = s_game_state.next_block_type;
+    prv_place_block(s_game_state.next_block_type);
     s_game_state.next_block_type = prv_get_next_piece();
 
-    GPoint new_block_pos = s_game_state.block_type == I ? GPoint(4, 0) : GPoint(5, 1);
-
-    make_block(s_game_state.block, s_game_state.block_type, new_block_pos.x, new_block_pos.y);
-
-    prv_check_block_out(s_game_state.block);
+    prv_check_block_out(&s_game_state.block);
 
     make_block(next_block, s_game_state.next_block_type, 0, 0);
   }
 
-  layer_mark_dirty(s_game_pane_layer);
+  prv_refresh_previews();
+  prv_refresh_piece();
 }
-#endif
 
-static void prv_game_move_piece(int movement){
-  if (s_status != GameStatusPlaying) { return; }
+// Put a new block of the given type at the top of the grid
+static void prv_place_block(Tetromino type){
+  s_game_state.block = (Piece) {
+    .type = type,
+    .rotation = 0,
+    .x = (type == I) ? 4 : 5,
+    .y = (type == I) ? 0 : 1
+  };
+  s_shift_press_moved = 0; // a chord doesn't take back a move of the previous block
+  prv_update_ghost();
+  if (!grid_collides(&s_game_state.block, 0, 0, &s_grid)) { prv_autoshift_follow(); } // a block out stays where it spawned
+}
 
-  // Move the block left, if possible.
-  for (int i=0; i<4; i++) {
-    int block_moved_x = s_game_state.block[i].x + movement;
-    if ((movement == LEFT && block_moved_x < 0) || (movement == RIGHT && block_moved_x > 9)) { return; }
-    if(s_grid_blocks[block_moved_x][s_game_state.block[i].y]) { return; }
-  }
+static bool prv_game_move_piece(int movement){
+  if (s_status != GameStatusPlaying || s_game_state.block.type == NONE) { return false; }
 
-  for (int i=0; i<4; i++) {
-    s_game_state.block[i].x += movement;
-  }
+  // Move the block left or right, if possible.
+  if (grid_collides(&s_game_state.block, movement, 0, &s_grid)) { return false; }
 
+  s_game_state.block.x += movement;
+
+  prv_update_ghost();
   prv_reset_lock_delay();
   
-  layer_mark_dirty(s_game_pane_layer);
+  prv_refresh_piece();
+  return true;
+}
+
+// Move the block as far as it goes in the direction
+static void prv_game_slide_piece(int direction){
+  if (s_status != GameStatusPlaying || s_game_state.block.type == NONE) { return; }
+
+  int move_amount = find_max_horiz_move(&s_game_state.block, &s_grid, direction);
+  if (move_amount == 0) { return; }
+
+  s_game_state.block.x += move_amount * direction;
+
+  prv_update_ghost();
+  prv_reset_lock_delay();
+
+  prv_refresh_piece();
+}
+
+static void prv_autoshift_press(int direction){
+  s_autoshift_direction = direction;
+  s_autoshift_charged = false;
+  scheduler_cancel(GameJobAutoShift);
+  if (s_status == GameStatusLost) { return; }
+
+  // While paused, the move and the DAS delay both wait for the game to resume
+  s_shift_press_time = scheduler_now();
+  prv_queue_input(direction == LEFT ? InputMoveLeft : InputMoveRight, scheduler_now());
+  scheduler_schedule(GameJobAutoShift, game_settings.set_das, prv_autoshift_tick, NULL);
+}
+
+static void prv_autoshift_release(int direction){
+  if (direction != s_autoshift_direction) { return; }
+
+  s_autoshift_direction = 0;
+  s_autoshift_charged = false;
+  scheduler_cancel(GameJobAutoShift);
+
+  // The other button is still held: it shifts again after its own DAS delay (but not while both soft drop)
+  int other = s_left_held ? LEFT : (s_right_held ? RIGHT : 0);
+  if (other != 0 && !(s_left_held && s_right_held) && s_status != GameStatusLost) {
+    s_autoshift_direction = other;
+    scheduler_schedule(GameJobAutoShift, game_settings.set_das, prv_autoshift_tick, NULL);
+  }
+}
+
+// With an instant repeat (ARR = 0), a charged auto-shift keeps the block against the wall after it rotates or spawns
+static void prv_autoshift_follow(){
+  if (!s_autoshift_charged || game_settings.set_arr != 0 || s_autoshift_direction == 0) { return; }
+  prv_game_slide_piece(s_autoshift_direction);
 }
 
 static void prv_game_rotate_piece() {
   // before rotation logic, is there a piece? (or if yes, is it not a square?)
-  if (s_game_state.block_type == NONE || s_game_state.block_type == O) { return; }
+  if (s_game_state.block.type == NONE || s_game_state.block.type == O) { return; }
 
-  int new_rotation = (s_game_state.rotation + 1) % 4;
+  int new_rotation = (s_game_state.block.rotation + 1) % 4;
   if(game_settings.set_counterclockwise){
-    new_rotation = (s_game_state.rotation - 1 + 4) % 4;
+    new_rotation = (s_game_state.block.rotation - 1 + 4) % 4;
   }
 
-  GPoint rotated_piece[4];
-  rotate_mino(rotated_piece, s_game_state.block, s_game_state.block_type, new_rotation);
-  
-  GPoint kicked_piece[4];
-  if(!rotate_try_kicks(kicked_piece, rotated_piece, s_game_state.block_type, s_game_state.rotation, new_rotation, s_grid_blocks)){
+  if(!rotate_try_kicks(&s_game_state.block, new_rotation, &s_grid)){
     return;
   }
 
-  for (int i=0; i<4; i++) {
-    s_game_state.block[i] = kicked_piece[i];
-  }
+  prv_update_ghost();
+  prv_reset_lock_delay();
+  prv_autoshift_follow();
 
-  s_game_state.rotation = new_rotation;
+  prv_refresh_piece();
+}
 
-  prv_reset_lock_delay();
+// Drop the block to the bottom and lock it right away, logging how long it took since the button press
+static void prv_hard_drop(uint32_t pressed_at) {
+  if (s_status != GameStatusPlaying || s_game_state.block.type == NONE) { return; }
 
-  layer_mark_dirty(s_game_pane_layer);
+  scheduler_cancel(GameJobLockDelay); // the block locks now, not when the delay runs out
+  s_game_state.block.y = s_ghost_y;
+  prv_lock_piece();
+
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Hard drop: %d ms from press to lock", (int)(scheduler_now() - pressed_at));
+  prv_schedule_spawn();
+}
+
+static void prv_update_ghost(){
+  s_ghost_y = s_game_state.block.y + find_max_drop(&s_game_state.block, &s_grid);
 }
 
 static void prv_reset_lock_delay(){
-  if(s_lockdelay_timer){
+  if(scheduler_is_scheduled(GameJobLockDelay)){
     if(s_lockdelay_maxmoves > 0) { 
       s_lockdelay_maxmoves--; 
-      app_timer_reschedule(s_lockdelay_timer, 500);
+      scheduler_reschedule(GameJobLockDelay, s_lockdelay_tick);
     } 
   }
 }
 
 static void prv_lock_piece(){
-  GPoint *block = s_game_state.block;
-  int8_t block_type = s_game_state.block_type;
+  int8_t block_type = s_game_state.block.type;
 
   // if the block type is -1 it means it's already been locked and we need to wait till next game cycle
   if(block_type == NONE) { return; }
@@ -779,67 +1292,65 @@ static void prv_lock_piece(){
   if(prv_can_drop()) { return; }
 
   // lock block for good
+  GPoint block[4];
+  piece_get_cells(&s_game_state.block, block);
+  int top = block[0].y, bottom = block[0].y;
   for (int i=0; i<4; i++) {
-    // Validating each block (especially since we now allow blocks above grid height or y<0)
-    if(block[i].x < 0 || block[i].y < 0) { continue; }
-    if(block[i].x >= GAME_GRID_BLOCK_WIDTH || block[i].y >= GAME_GRID_BLOCK_HEIGHT) { continue; }
+    if(block[i].y < top) { top = block[i].y; }
+    if(block[i].y > bottom) { bottom = block[i].y; }
+
+    // Cells above the buffer zone don't fit in the grid, the piece tops out anyway
+    if(block[i].y < GRID_TOP_ROW) { continue; }
     
     // Locking block in the arrays
-    s_grid_blocks[block[i].x][block[i].y] = true;
-    s_grid_colors[block[i].x][block[i].y] = block_type;
+    grid_set_cell(&s_grid, block[i].x, block[i].y, block_type);
   }
 
-  layer_mark_dirty(s_bg_layer);
+  prv_invalidate_board(top, bottom);
   
   // Clear rows if possible.
-  prv_clear_rows();
+  prv_clear_rows(&s_game_state.block);
   
   // check if the block is outside the grid
-  prv_check_top_out(s_game_state.block);
+  prv_check_top_out(&s_game_state.block);
 
   // Mark for new block
-  s_game_state.block_type = NONE;
+  s_game_state.block.type = NONE;
+  if (s_game_state.pieces < UINT16_MAX) { s_game_state.pieces++; }
+
+  if (s_status == GameStatusPlaying && s_game_state.mode == GameModeSprint && s_game_state.lines_cleared >= SPRINT_LINES) {
+    prv_game_over("Finished!");
+  }
 }
 
-static void prv_clear_rows(){
-  for (int j=0; j<20; j++) { // test for all rows
-    bool isRow = true;
+static void prv_clear_rows(Piece *piece){
+  s_cleared_rows_count = grid_find_full_rows(piece, &s_grid, s_cleared_rows);
+  if (s_cleared_rows_count == 0) { return; }
 
-    for (int i=0; i<10; i++) {
-      if (!s_grid_blocks[i][j]) { isRow = false; } // if one block in row j is empty then it's not a row
-    }
+  s_game_state.lines_cleared += s_cleared_rows_count;
 
-    if (!isRow) { continue; }
-
-    s_game_state.lines_cleared += 1;
-    s_lines_cleared_at_once += 1;
-
-    // Check if we have to level up
-    if (s_game_state.level < 10 && s_game_state.lines_cleared >= (10 * s_game_state.level)) { // every 10 line clears, go up 1 level, up to level 10
-      s_game_state.level += 1; 
-      s_tick_time -= s_tick_interval;
-
-      update_string_num_layer("LV.", s_game_state.level, s_level_str, sizeof(s_level_str), s_level_layer);
-      
-      // Save game when level up, to not lose too much progress if app is interrupted
-      prv_save_game(); 
-    }    
-    // Drop the above rows.
-    for (int k=j; k>0; k--) {
-      for (int i=0; i<10; i++) {
-        s_grid_blocks[i][k] = s_grid_blocks[i][k-1];
-        s_grid_colors[i][k] = s_grid_colors[i][k-1];
-      }
-    }
-    
-    for (int i=0; i<10; i++) {
-      s_grid_blocks[i][0] = false;
-      s_grid_colors[i][0] = 255;
-    }
+  // Every row from the top of the stack down to the lowest cleared one moves or empties
+  int stack_top = GAME_GRID_BLOCK_HEIGHT;
+  for (int i=0; i<GAME_GRID_BLOCK_WIDTH; i++) {
+    if (s_grid.column_top[i] < stack_top) { stack_top = s_grid.column_top[i]; }
+  }
+
+  grid_clear_rows(&s_grid, s_cleared_rows, s_cleared_rows_count);
+  prv_invalidate_board(stack_top, s_cleared_rows[s_cleared_rows_count - 1]);
+
+  // Check if we have to level up
+  if (s_game_state.level < UINT8_MAX && s_game_state.lines_cleared >= (10 * s_game_state.level)) { // every 10 line clears, go up 1 level
+    prv_report_tick_stats();
+    s_game_state.level += 1; 
+    prv_update_gravity();
+
+    prv_update_level_label();
     
+    // Save game when level up, to not lose too much progress if app is interrupted
+    prv_save_game(); 
   }
-  
-  switch(s_lines_cleared_at_once) {
+
+  switch(s_cleared_rows_count) {
     case 1: 
       s_game_state.score += (40 * s_game_state.level);
       break;
@@ -852,8 +1363,8 @@ static void prv_clear_rows(){
     case 4:
       s_game_state.score += (1200 * s_game_state.level);
       vibes_short_pulse();
-      if(!s_flash_timer) {
-        s_flash_timer = app_timer_register(s_flash_tick, prv_flash_tick, NULL);
+      if(!scheduler_is_scheduled(GameJobFlash)) {
+        scheduler_schedule(GameJobFlash, s_flash_tick, prv_flash_tick, NULL);
       }
       break;
     default: break;
@@ -864,40 +1375,51 @@ static void prv_clear_rows(){
 
   update_string_num_layer("SCORE\n", s_game_state.score, s_score_str, sizeof(s_score_str), s_score_layer);
   update_string_num_layer("LINES\n", s_game_state.lines_cleared, s_lines_str, sizeof(s_lines_str), s_lines_layer);
-
-  s_lines_cleared_at_once = 0;
 }
 
 static void prv_game_lost(){
+  prv_game_over("You lost!");
+}
+
+// End the game, lost or not (Sprint and Ultra end by themselves), with the message shown over the grid
+static void prv_game_over(char *message){
   s_status = GameStatusLost;      
-  s_game_timer = NULL;
+  scheduler_cancel_all();
+  prv_clock_stop();
+  prv_update_level_label(); // final time
+  prv_report_tick_stats();
+  prv_report_session_stats();
   prv_save_game();
 
-  text_layer_set_text(s_paused_label_layer, "You lost!");
+  text_layer_set_text(s_paused_label_layer, message);
   layer_add_child(window_get_root_layer(s_window), text_layer_get_layer(s_paused_label_layer));
 }
 
-// Check whether you've lost by seeing if the current block is outside the top of the grid.
-static void prv_check_top_out(GPoint *block){
+// Check whether you've lost by seeing if the current block locked entirely above the visible field (lock out),
+// or partly above the buffer zone.
+static void prv_check_top_out(Piece *piece){
+  GPoint block[4];
+  piece_get_cells(piece, block);
+  bool visible = false;
   for (int i=0; i<4; i++) {
-    if (block[i].y >= 0) { continue; }
-    
-    prv_game_lost();
-    return;
+    if (block[i].y < GRID_TOP_ROW) { 
+      prv_game_lost();
+      return;
+    }
+    if (block[i].y >= 0) { visible = true; }
   }
+
+  if (!visible) { prv_game_lost(); }
 }
 
 // Check whether you've lost by seeing if the current block is overlapping existing blocks.
-static void prv_check_block_out(GPoint *block){
-  for (int i=0; i<4; i++) {
-    if (!s_grid_blocks[block[i].x][block[i].y]) { continue; }
+static void prv_check_block_out(Piece *piece){
+  if (!grid_collides(piece, 0, 0, &s_grid)) { return; }
     
-    // lock the piece to show it on the screen
-    prv_lock_piece();
-    
-    prv_game_lost();
-    return;
-  }
+  // lock the piece to show it on the screen
+  prv_lock_piece();
+  
+  prv_game_lost();
 }
 
 static void prv_refill_mino_bag() {
@@ -930,45 +1452,235 @@ static Tetromino prv_get_next_piece() {
 // ***** TICK FUNCTIONS ***** //
 // -------------------------- //
 
+static void prv_update_gravity() {
+  const int levels = sizeof(s_level_row_ms) / sizeof(s_level_row_ms[0]);
+  uint16_t row_ms = s_level_row_ms[(s_game_state.level < levels ? s_game_state.level : levels) - 1];
+
+  const int32_t max_gravity = GAME_GRID_TOTAL_HEIGHT << GRAVITY_SHIFT; // 20G: the whole grid height in a single step
+  if (row_ms == 0) {
+    s_gravity = max_gravity;
+  } else {
+    s_gravity = (((int32_t)GRAVITY_STEP_MS << GRAVITY_SHIFT) + row_ms - 1) / row_ms; // rounded up, so a row never takes longer than the table says
+  }
+
+  if (s_soft_drop) {
+    int64_t soft_gravity = (int64_t)s_gravity * game_settings.set_soft_drop_factor;
+    s_gravity = soft_gravity < max_gravity ? soft_gravity : max_gravity;
+  }
+}
+
+// Change the gravity between normal and soft drop without waiting for the running step to end:
+// the steps already elapsed fall at the old gravity, and the next tick is scheduled at the new one.
+static void prv_set_soft_drop(bool soft_drop) {
+  if (soft_drop == s_soft_drop) { return; }
+  s_soft_drop = soft_drop;
+
+  if (s_status != GameStatusPlaying || !scheduler_is_scheduled(GameJobGravity)) {
+    prv_update_gravity();
+    return;
+  }
+
+  uint32_t from = scheduler_deadline(GameJobGravity) - s_gravity_steps * GRAVITY_STEP_MS;
+  int32_t elapsed = (int32_t)(scheduler_now() - from);
+  int steps = elapsed > 0 ? elapsed / GRAVITY_STEP_MS : 0;
+  if (steps >= s_gravity_steps) { steps = s_gravity_steps - 1; } // that one is the tick itself
+
+  s_gravity_acc += s_gravity * steps;
+  prv_update_gravity();
+  prv_schedule_game_tick(from + steps * GRAVITY_STEP_MS);
+}
+
+// Skip ahead to the step where the accumulator reaches the next whole row, counting from the given step deadline
+static void prv_schedule_game_tick(uint32_t from) {
+  s_gravity_steps = 1;
+  if (s_gravity < GRAVITY_ONE_ROW) {
+    s_gravity_steps = (GRAVITY_ONE_ROW - s_gravity_acc + s_gravity - 1) / s_gravity;
+    if (s_gravity_steps < 1) { s_gravity_steps = 1; }
+  }
+  scheduler_schedule_at(GameJobGravity, from + s_gravity_steps * GRAVITY_STEP_MS, prv_game_tick, NULL);
+}
+
 static void prv_game_tick(void *data) {
   if (s_status != GameStatusPlaying) { return; }
 
+  // If the tick runs late, catch up on the steps it missed
+  uint32_t now = scheduler_now();
+  uint32_t deadline = scheduler_deadline(GameJobGravity);
+  int32_t late = (int32_t)(now - deadline);
+  int steps = s_gravity_steps + (late > 0 ? late / GRAVITY_STEP_MS : 0);
+  deadline += (steps - s_gravity_steps) * GRAVITY_STEP_MS;
+
+  prv_record_tick(now, steps * GRAVITY_STEP_MS);
+
+  int64_t acc = s_gravity_acc + (int64_t)s_gravity * steps;
+  const int64_t max_acc = (int64_t)GAME_GRID_TOTAL_HEIGHT << GRAVITY_SHIFT; // more can't fall anyway
+  s_gravity_acc = acc < max_acc ? acc : max_acc;
+
   prv_game_cycle();
-  s_game_timer = app_timer_register(s_tick_time, prv_game_tick, NULL);
+  if (s_status != GameStatusPlaying) { return; } // the block that just spawned topped out
+
+  // A block resting on the stack has nothing to fall, the lock delay takes it from here
+  if (s_game_state.block.type != NONE && !prv_can_drop()) { return; }
+  prv_schedule_game_tick(deadline);
+}
+
+static void prv_record_tick(uint32_t now, uint32_t target) {
+  if (s_tick_stats.last_tick != 0) {
+    int32_t period = now - s_tick_stats.last_tick;
+    s_tick_stats.ticks++;
+    s_tick_stats.period_sum += period;
+    s_tick_stats.target_sum += target;
+    s_tick_stats.jitter_sum += abs(period - (int32_t)target);
+  }
+  s_tick_stats.last_tick = now;
+}
+
+// Log the mean period and jitter of the gravity ticks since the last report, then start over
+static void prv_report_tick_stats() {
+  if (s_tick_stats.ticks > 0) {
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "LV.%d gravity: %d ticks, mean period %d ms (target %d ms), jitter %d ms",
+      s_game_state.level, (int)s_tick_stats.ticks,
+      (int)(s_tick_stats.period_sum / s_tick_stats.ticks),
+      (int)(s_tick_stats.target_sum / s_tick_stats.ticks),
+      (int)(s_tick_stats.jitter_sum / s_tick_stats.ticks));
+  }
+  s_tick_stats = (TickStats) { 0 };
+}
+
+// Log the pieces and player actions per second over the whole game so far
+static void prv_report_session_stats() {
+  uint32_t time = prv_game_time();
+  if (time == 0) { return; }
+
+  uint32_t pieces_per_100s = (uint32_t)s_game_state.pieces * 100000 / time;
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "Game: %d pieces and %d inputs in %d ms, %d.%02d pieces/s, %d inputs/min",
+    s_game_state.pieces, s_game_state.inputs, (int)time,
+    (int)(pieces_per_100s / 100), (int)(pieces_per_100s % 100),
+    (int)((uint32_t)s_game_state.inputs * 60000 / time));
+}
+
+// Time played in ms, pauses excluded
+static uint32_t prv_game_time() {
+  if (!s_clock_running) { return s_game_state.time_ms; }
+
+  // The watch clock can be set back, the game clock never goes back with it
+  int32_t elapsed = scheduler_now() - s_clock_start;
+  return s_game_state.time_ms + (elapsed > 0 ? elapsed : 0);
+}
+
+static void prv_clock_start() {
+  if (s_clock_running || s_status != GameStatusPlaying) { return; }
+
+  s_clock_start = scheduler_now();
+  s_clock_running = true;
+  prv_schedule_clock_tick();
+}
+
+static void prv_clock_stop() {
+  if (!s_clock_running) { return; }
+
+  s_game_state.time_ms = prv_game_time();
+  s_clock_running = false;
+  scheduler_cancel(GameJobClock);
+}
+
+// Sprint and Ultra show the time instead of the level: wake up when its seconds change, or when Ultra's time is up
+static void prv_schedule_clock_tick() {
+  if (s_game_state.mode == GameModeMarathon) { return; }
+
+  uint32_t time = prv_game_time();
+  uint32_t delay = 1000 - time % 1000;
+  if (s_game_state.mode == GameModeUltra) {
+    uint32_t left = time < ULTRA_MS ? ULTRA_MS - time : 0;
+    if (left < delay) { delay = left; }
+  }
+  scheduler_schedule(GameJobClock, delay, prv_clock_tick, NULL);
+}
+
+static void prv_clock_tick(void *data) {
+  if (s_status != GameStatusPlaying) { return; }
+
+  if (s_game_state.mode == GameModeUltra && prv_game_time() >= ULTRA_MS) {
+    prv_game_over("Time's up!");
+    return;
+  }
+
+  prv_update_level_label();
+  prv_schedule_clock_tick();
+}
+
+// Level in Marathon, time played in Sprint, time left in Ultra
+static void prv_update_level_label() {
+  if (s_game_state.mode == GameModeMarathon) {
+    update_string_num_layer("LV.", s_game_state.level, s_level_str, sizeof(s_level_str), s_level_layer);
+    return;
+  }
+
+  uint32_t seconds = prv_game_time() / 1000;
+  if (s_game_state.mode == GameModeUltra) {
+    uint32_t time = prv_game_time();
+    seconds = time < ULTRA_MS ? (ULTRA_MS - time + 999) / 1000 : 0;
+  }
+  snprintf(s_level_str, sizeof(s_level_str), "%d:%02d", (int)(seconds / 60), (int)(seconds % 60));
+  text_layer_set_text(s_level_layer, s_level_str);
 }
 
-static void prv_s_longpress_tick(void *data) {
-  if (s_status != GameStatusPlaying || s_longpress_movement_direction == 0) {
-    s_longpress_timer = NULL;
-    return; 
+static void prv_autoshift_tick(void *data) {
+  if (s_status != GameStatusPlaying || s_autoshift_direction == 0) { return; }
+
+  s_autoshift_charged = true;
+  // Between lock and spawn there's no block to repeat on: only the charge carries over, so the queue keeps room
+  // for the player's own presses (the next block picks the charge up in prv_autoshift_follow() or the next repeat)
+  bool has_block = s_game_state.block.type != NONE;
+  if (game_settings.set_arr == 0) {
+    if (has_block) { prv_queue_input(s_autoshift_direction == LEFT ? InputSlideLeft : InputSlideRight, scheduler_now()); }
+    return;
   }
 
-  prv_game_move_piece(s_longpress_movement_direction);
-  s_longpress_timer = app_timer_register(s_longpress_tick, prv_s_longpress_tick, NULL);
+  if (has_block) { prv_queue_input(s_autoshift_direction == LEFT ? InputRepeatLeft : InputRepeatRight, scheduler_now()); }
+  scheduler_schedule(GameJobAutoShift, game_settings.set_arr, prv_autoshift_tick, NULL);
 }
 
 static void prv_lockdelay_tick(void *data) {
   if (s_status != GameStatusPlaying) { return; }
 
   prv_lock_piece();
-  s_lockdelay_timer = NULL;
+  prv_schedule_spawn();
+}
+
+static void prv_input_tick(void *data) {
+  if (s_status != GameStatusPlaying) { return; }
+
+  prv_drain_inputs();
+}
+
+static void prv_spawn_tick(void *data) {
+  if (s_status != GameStatusPlaying || s_game_state.block.type != NONE) { return; }
+
+  prv_spawn_block();
+  prv_refresh_piece();
+
+  // Gravity counts from the spawn, whatever the phase of the previous block's ticks
+  if (s_status == GameStatusPlaying) {
+    s_tick_stats.last_tick = 0; // the time between blocks isn't a tick period
+    prv_schedule_game_tick(scheduler_now());
+  }
 }
 
 static void prv_flash_tick(void *data) {
   if (s_status != GameStatusPlaying) { return; }
 
   if (s_flash_amount == 0) {
-    s_flash_timer = NULL;
     s_flash_amount = 5;
     theme.grid_bg_color = s_og_bg_color;
-    layer_mark_dirty(s_bg_layer);
+    prv_invalidate_board(0, GAME_GRID_BLOCK_HEIGHT - 1);
     return;
   }
 
   theme.grid_bg_color = s_flash_amount % 2 ? s_og_bg_color : s_flash_bg_color;
   s_flash_amount--;
-  layer_mark_dirty(s_bg_layer);
-  s_flash_timer = app_timer_register(s_flash_tick, prv_flash_tick, NULL);
+  prv_invalidate_board(0, GAME_GRID_BLOCK_HEIGHT - 1); // the stored rows have the old background
+  scheduler_schedule(GameJobFlash, s_flash_tick, prv_flash_tick, NULL);
 }
 
 // -------------------------- //
@@ -981,27 +1693,34 @@ static void prv_setup_game() {
   s_game_state.lines_cleared = 0;
   s_game_state.level = 1;
   s_game_state.score = 0;
-  s_game_state.rotation = 0;
 
   prv_refill_mino_bag();
   
-  s_game_state.block_type = NONE;
+  s_game_state.block.type = NONE;
   s_game_state.next_block_type = prv_get_next_piece();
   s_game_state.held_block_type = NONE;
   s_game_state.can_hold_block = true;
-
-  for (int i=0; i<GAME_GRID_BLOCK_WIDTH; i++) {
-    for (int j=0; j<GAME_GRID_BLOCK_HEIGHT; j++) {
-      s_grid_blocks[i][j] = false;
-      s_grid_colors[i][j] = 255;
-    }
-  }
-
-  s_tick_time = s_max_tick;
+  s_game_state.mode = game_settings.set_game_mode % GAME_MODES;
+  s_game_state.time_ms = 0;
+  s_game_state.pieces = 0;
+  s_game_state.inputs = 0;
+  s_clock_running = false;
+
+  grid_init(&s_grid);
+  prv_invalidate_board(0, GAME_GRID_BLOCK_HEIGHT - 1);
+
+  s_gravity_acc = 0;
+  s_soft_drop = false;
+  s_left_held = false;
+  s_right_held = false;
+  s_autoshift_direction = 0;
+  s_input_head = 0;
+  s_input_count = 0;
+  prv_update_gravity();
   s_mino_bag[0] = s_game_state.next_block_type;
   
   update_string_num_layer("SCORE\n", 0, s_score_str, sizeof(s_score_str), s_score_layer);
-  update_string_num_layer("LV.", s_game_state.level, s_level_str, sizeof(s_level_str), s_level_layer);
+  prv_update_level_label();
   update_string_num_layer("LINES\n", 0, s_lines_str, sizeof(s_lines_str), s_lines_layer);
 
 }
@@ -1015,11 +1734,14 @@ static void prv_load_game() {
     // DEALING WITH V1 SAVES (= no known GAME_SAVE_VERSION)
     if(!persist_exists(GAME_SAVE_VERSION_KEY)) {
       prv_migrate_v1_save();
+    } else if (persist_read_int(GAME_SAVE_VERSION_KEY) < 4) {
+      prv_migrate_v2_save();
+    } else if (persist_read_int(GAME_SAVE_VERSION_KEY) < 6) {
+      prv_migrate_v4_save();
     } else {
       persist_read_data(GAME_STATE_KEY, &s_game_state, sizeof(GameState));
     }
-    persist_read_data(GAME_GRID_BLOCK_KEY, &s_grid_blocks, sizeof(s_grid_blocks));
-    persist_read_data(GAME_GRID_COLOR_KEY, &s_grid_colors, sizeof(s_grid_colors));
+    prv_load_grid();
   } else {
     // Error: couldnt find data
     APP_LOG(APP_LOG_LEVEL_ERROR, "No saved data");
@@ -1027,18 +1749,20 @@ static void prv_load_game() {
   }
 
   update_string_num_layer("SCORE\n", s_game_state.score, s_score_str, sizeof(s_score_str), s_score_layer);
-  update_string_num_layer("LV.",     s_game_state.level, s_level_str, sizeof(s_level_str), s_level_layer);
+  prv_update_level_label();
   update_string_num_layer("LINES\n", s_game_state.lines_cleared, s_lines_str, sizeof(s_lines_str), s_lines_layer);
 
   make_block(next_block, s_game_state.next_block_type, 0, 0);
 
-  #ifdef CAPABILITY_HELD_BLOCK
-    if(s_game_state.held_block_type != NONE){
-      make_block(held_block, s_game_state.held_block_type, 0, 0);
-    }
-  #endif
+  if(s_game_state.block.type != NONE){
+    prv_update_ghost();
+  }
 
-  s_tick_time = s_max_tick - (s_tick_interval * s_game_state.level);
+  if(s_game_state.held_block_type != NONE){
+    make_block(held_block, s_game_state.held_block_type, 0, 0);
+  }
+
+  prv_update_gravity();
 }
 
 static void prv_quit_after_loss() {
@@ -1047,16 +1771,38 @@ static void prv_quit_after_loss() {
     prv_save_game();
   }
 
+  // Sprint ranks the time to clear its lines, there's nothing to rank if it wasn't finished
+  uint32_t result = s_game_state.score;
+  if (s_game_state.mode == GameModeSprint) {
+    result = s_game_state.lines_cleared >= SPRINT_LINES ? s_game_state.time_ms : 0;
+  }
+
   window_stack_pop(true);
-  new_score_window_push(s_game_state.score, s_game_state.level);
+  new_score_window_push(s_game_state.mode, result, s_game_state.level);
 }
 
 static void prv_save_game() {
   if(s_status != GameStatusLost) {
+    // Bank the time played so far, the clock goes on from there
+    if (s_clock_running) {
+      s_game_state.time_ms = prv_game_time();
+      s_clock_start = scheduler_now();
+    }
     persist_write_int(GAME_SAVE_VERSION_KEY, GAME_SAVE_VERSION);
     persist_write_data(GAME_STATE_KEY, &s_game_state, sizeof(GameState));
-    persist_write_data(GAME_GRID_BLOCK_KEY, &s_grid_blocks, sizeof(s_grid_blocks)); // the GRID arrays are too big to fit with the rest of the game state
-    persist_write_data(GAME_GRID_COLOR_KEY, &s_grid_colors, sizeof(s_grid_colors)); // ...as the persist keys can only each hold 256 bytes 
+    // Colors are saved in logical row order, the row bitmasks are rebuilt from them on load.
+    // The GRID array is too big to fit with the rest of the game state, as the persist keys can only each hold 256 bytes
+    for (int k=0; k<GAME_GRID_COLOR_KEYS; k++) {
+      uint8_t grid_colors[GAME_GRID_COLOR_ROWS_PER_KEY][GAME_GRID_BLOCK_WIDTH];
+      int first_row = GRID_TOP_ROW + k * GAME_GRID_COLOR_ROWS_PER_KEY;
+      int row_count = GAME_GRID_BLOCK_HEIGHT - first_row;
+      if (row_count > GAME_GRID_COLOR_ROWS_PER_KEY) { row_count = GAME_GRID_COLOR_ROWS_PER_KEY; }
+      for (int j=0; j<row_count; j++) {
+        memcpy(grid_colors[j], GRID_ROW_COLORS(&s_grid, first_row + j), GAME_GRID_BLOCK_WIDTH);
+      }
+      persist_write_data(GAME_GRID_COLOR_KEY + k, grid_colors, row_count * GAME_GRID_BLOCK_WIDTH);
+    }
+    persist_delete(GAME_GRID_BLOCK_KEY); // occupancy is rebuilt from the colors on load, so older saves' block grid is not needed anymore
     persist_write_bool(GAME_CONTINUE_KEY, true);
     APP_LOG(APP_LOG_LEVEL_INFO, "SAVED GAME");
     return;
@@ -1065,11 +1811,55 @@ static void prv_save_game() {
     persist_delete(GAME_SAVE_VERSION_KEY);
     persist_delete(GAME_STATE_KEY);
     persist_delete(GAME_GRID_BLOCK_KEY);
-    persist_delete(GAME_GRID_COLOR_KEY);
+    for (int k=0; k<GAME_GRID_COLOR_KEYS; k++) {
+      persist_delete(GAME_GRID_COLOR_KEY + k);
+    }
     persist_write_bool(GAME_CONTINUE_KEY, false);
   }
 }
 
+static void prv_load_grid() {
+  grid_init(&s_grid);
+  prv_invalidate_board(0, GAME_GRID_BLOCK_HEIGHT - 1);
+
+  // v1 & v2 saves stored the colors column by column
+  if (persist_read_int(GAME_SAVE_VERSION_KEY) < 3) {
+    uint8_t grid_colors[GAME_GRID_BLOCK_WIDTH][GAME_GRID_BLOCK_HEIGHT];
+    persist_read_data(GAME_GRID_COLOR_KEY, grid_colors, sizeof(grid_colors));
+    for (int i=0; i<GAME_GRID_BLOCK_WIDTH; i++) {
+      for (int j=0; j<GAME_GRID_BLOCK_HEIGHT; j++) {
+        if (grid_colors[i][j] != GRID_CELL_EMPTY) { grid_set_cell(&s_grid, i, j, grid_colors[i][j]); }
+      }
+    }
+    return;
+  }
+
+  // v3 & v4 saves had no buffer zone, and all the colors in one key
+  if (persist_read_int(GAME_SAVE_VERSION_KEY) < 5) {
+    uint8_t grid_colors[GAME_GRID_BLOCK_HEIGHT][GAME_GRID_BLOCK_WIDTH];
+    persist_read_data(GAME_GRID_COLOR_KEY, grid_colors, sizeof(grid_colors));
+    for (int j=0; j<GAME_GRID_BLOCK_HEIGHT; j++) {
+      for (int i=0; i<GAME_GRID_BLOCK_WIDTH; i++) {
+        if (grid_colors[j][i] != GRID_CELL_EMPTY) { grid_set_cell(&s_grid, i, j, grid_colors[j][i]); }
+      }
+    }
+    return;
+  }
+
+  for (int k=0; k<GAME_GRID_COLOR_KEYS; k++) {
+    uint8_t grid_colors[GAME_GRID_COLOR_ROWS_PER_KEY][GAME_GRID_BLOCK_WIDTH];
+    int first_row = GRID_TOP_ROW + k * GAME_GRID_COLOR_ROWS_PER_KEY;
+    int row_count = GAME_GRID_BLOCK_HEIGHT - first_row;
+    if (row_count > GAME_GRID_COLOR_ROWS_PER_KEY) { row_count = GAME_GRID_COLOR_ROWS_PER_KEY; }
+    persist_read_data(GAME_GRID_COLOR_KEY + k, grid_colors, row_count * GAME_GRID_BLOCK_WIDTH);
+    for (int j=0; j<row_count; j++) {
+      for (int i=0; i<GAME_GRID_BLOCK_WIDTH; i++) {
+        if (grid_colors[j][i] != GRID_CELL_EMPTY) { grid_set_cell(&s_grid, i, first_row + j, grid_colors[j][i]); }
+      }
+    }
+  }
+}
+
 static void prv_migrate_v1_save() {
   typedef struct {
     GPoint block[4];
@@ -1086,12 +1876,67 @@ static void prv_migrate_v1_save() {
 
   persist_read_data(GAME_STATE_KEY, &old, sizeof(GameState_v1));
 
-  memcpy(s_game_state.block, old.block, sizeof(old.block));
+  // block[0] is always the pivot of the piece
+  s_game_state.block = (Piece) { .type = old.block_type, .rotation = old.rotation, .x = old.block[0].x, .y = old.block[0].y };
+
+  s_game_state.next_block_type = old.next_block_type;
+  s_game_state.lines_cleared   = old.lines_cleared;
+  s_game_state.level           = old.level;
+  s_game_state.score           = old.score;
+  s_game_state.mode            = GameModeMarathon;
+}
+
+// v2 & v3 saves stored the 4 cells of the falling block instead of its pivot
+static void prv_migrate_v2_save() {
+  typedef struct {
+    GPoint block[4];
+    uint8_t rotation;
+    Tetromino block_type;
+    Tetromino next_block_type;
+    Tetromino held_block_type;
+    uint16_t lines_cleared;
+    uint8_t level;
+    uint32_t score;
+    bool can_hold_block;
+  } GameState_v2;
+
+  GameState_v2 old;
+
+  persist_read_data(GAME_STATE_KEY, &old, sizeof(GameState_v2));
+
+  s_game_state.block = (Piece) { .type = old.block_type, .rotation = old.rotation, .x = old.block[0].x, .y = old.block[0].y };
+
+  s_game_state.next_block_type = old.next_block_type;
+  s_game_state.held_block_type = old.held_block_type;
+  s_game_state.lines_cleared   = old.lines_cleared;
+  s_game_state.level           = old.level;
+  s_game_state.score           = old.score;
+  s_game_state.can_hold_block  = old.can_hold_block;
+  s_game_state.mode            = GameModeMarathon;
+}
+
+// v4 & v5 saves had no game mode, clock or stats
+static void prv_migrate_v4_save() {
+  typedef struct {
+    Piece block;
+    Tetromino next_block_type;
+    Tetromino held_block_type;
+    uint16_t lines_cleared;
+    uint8_t level;
+    uint32_t score;
+    bool can_hold_block;
+  } GameState_v4;
+
+  GameState_v4 old;
+
+  persist_read_data(GAME_STATE_KEY, &old, sizeof(GameState_v4));
 
-  s_game_state.rotation        = old.rotation;
-  s_game_state.block_type      = old.block_type;
+  s_game_state.block           = old.block;
   s_game_state.next_block_type = old.next_block_type;
+  s_game_state.held_block_type = old.held_block_type;
   s_game_state.lines_cleared   = old.lines_cleared;
   s_game_state.level           = old.level;
   s_game_state.score           = old.score;
-}
\ No newline at end of file
+  s_game_state.can_hold_block  = old.can_hold_block;
+  s_game_state.mode            = GameModeMarathon;
+}
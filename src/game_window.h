@@ -2,7 +2,6 @@
 
 #ifdef PBL_TOUCH
   #define TOUCH_MARGIN 24
-  #define CAPABILITY_HELD_BLOCK
 #endif
 
 #ifdef PBL_PLATFORM_EMERY
@@ -34,6 +33,7 @@
   #define NEXT_BLOCK_Y (GRID_ORIGIN_Y + BLOCK_SIZE * 5)
 
   #define HELD_BLOCK_X (GRID_ORIGIN_X - BLOCK_SIZE * 3)
+  #define HELD_BLOCK_Y (NEXT_BLOCK_Y)
 #else
   #define GRID_PIXEL_WIDTH (BLOCK_SIZE * GAME_GRID_BLOCK_WIDTH)
   #define GRID_PIXEL_HEIGHT (BLOCK_SIZE * GAME_GRID_BLOCK_HEIGHT)
@@ -57,6 +57,9 @@
 
     #define NEXT_BLOCK_X (LABEL_X + (LABEL_WIDTH / 2)) - BLOCK_SIZE/2
     #define NEXT_BLOCK_Y (GRID_ORIGIN_Y + BLOCK_SIZE)
+
+    #define HELD_BLOCK_X (NEXT_BLOCK_X)
+    #define HELD_BLOCK_Y (NEXT_BLOCK_Y + BLOCK_SIZE * 4.5)
   #else
     #define LABEL_X (GRID_ORIGIN_X + GRID_PIXEL_WIDTH + GRID_PADDING + 1)
     #define LABEL_SCORE_X (LABEL_X)
@@ -71,6 +74,10 @@
 
     #define NEXT_BLOCK_X (LABEL_X + (LABEL_WIDTH / 2)) - BLOCK_SIZE/2
     #define NEXT_BLOCK_Y (GRID_ORIGIN_Y + BLOCK_SIZE * 2)
+
+    // no room above the labels, the held block goes in the gap between the lines label and the bottom of the grid
+    #define HELD_BLOCK_X (NEXT_BLOCK_X)
+    #define HELD_BLOCK_Y (LABEL_LINES_Y + BLOCK_SIZE * 4.75)
   #endif
 #endif
 
@@ -82,15 +89,17 @@ enum GameStatus {
 typedef enum GameStatus GameStatus;
 
 typedef struct {
-  GPoint block[4];
-  uint8_t rotation;
-  Tetromino block_type;
+  Piece block;
   Tetromino next_block_type;
   Tetromino held_block_type;
   uint16_t lines_cleared;
   uint8_t level;
   uint32_t score;
   bool can_hold_block;
+  uint8_t mode;     // GameMode
+  uint32_t time_ms; // time played, pauses excluded
+  uint16_t pieces;  // blocks locked
+  uint16_t inputs;  // player actions
 } GameState;
 
 void new_game();
@@ -5,219 +5,254 @@ void update_string_num_layer (char* str_in, int num, char* str_out, size_t out_s
   text_layer_set_text(layer, str_out);
 }
 
-const GPoint SHAPES[BLOCK_TYPES][4] = {
-  { 
-    // Origin of the grid is in the top left
-    // X  Y        * = pivot point at x = 0 & y = 0 at index [0] (part of shape that never rotates)
-    {  0,  0 },  // O
-    { -1,  0 },  // |2|3 |
-    { -1, -1 },  // |1|0*|
-    {  0, -1 }
-  },
-  { 
-    {  0, 0 },
-    { -1, 0 },  // I
-    {  1, 0 },  // |1|0*|2|3|
-    {  2, 0 }   
-  },
-  {
-    {  0,  0 }, // J
-    { -1, -1 }, // |1|
-    { -1,  0 }, // |2|0*|3|
-    {  1,  0 }  
-  },
-  {
-    {  0,  0 }, // L
-    { -1,  0 }, //      |3|
-    {  1,  0 }, // |1|0*|2|
-    {  1, -1 }
-  },
-  {
-    {  0,  0 }, // S
-    {  1, -1 }, //   |2 |1|
-    {  0, -1 }, // |3|0*|
-    { -1,  0 }
-  },
-  {
-    {  0,  0 }, // Z 
-    { -1, -1 }, // |1|2 |
-    {  0, -1 }, //   |0*|3|
-    {  1,  0 }
-  },
-  {
-    {  0,  0 }, // T
-    { -1,  0 }, //   |3 |   
-    {  1,  0 }, // |1|0*|2|
-    {  0, -1 }
-  }
+// Each tetromino as a list of cells relative to its pivot, in spawn orientation.
+// Origin of the grid is in the top left
+// CELL(X, Y, A) * = pivot point at x = 0 & y = 0 at index [0] (part of shape that never rotates)
+//               A is passed through untouched, for the macros that need more context
+#define SHAPE_O(CELL, A) CELL( 0, 0, A) CELL(-1, 0, A) CELL(-1,-1, A) CELL( 0,-1, A) // |2|3 |  
+                                                                                  // |1|0*|
+#define SHAPE_I(CELL, A) CELL( 0, 0, A) CELL(-1, 0, A) CELL( 1, 0, A) CELL( 2, 0, A) // |1|0*|2|3|
+
+#define SHAPE_J(CELL, A) CELL( 0, 0, A) CELL(-1,-1, A) CELL(-1, 0, A) CELL( 1, 0, A) // |1|
+                                                                                  // |2|0*|3|
+#define SHAPE_L(CELL, A) CELL( 0, 0, A) CELL(-1, 0, A) CELL( 1, 0, A) CELL( 1,-1, A) //      |3|
+                                                                                  // |1|0*|2|
+#define SHAPE_S(CELL, A) CELL( 0, 0, A) CELL( 1,-1, A) CELL( 0,-1, A) CELL(-1, 0, A) //   |2 |1|
+                                                                                  // |3|0*|
+#define SHAPE_Z(CELL, A) CELL( 0, 0, A) CELL(-1,-1, A) CELL( 0,-1, A) CELL( 1, 0, A) // |1|2 |
+                                                                                  //   |0*|3|
+#define SHAPE_T(CELL, A) CELL( 0, 0, A) CELL(-1, 0, A) CELL( 1, 0, A) CELL( 0,-1, A) //   |3 |
+                                                                                  // |1|0*|2|
+
+// Clockwise rotations of a cell around the pivot
+#define CELL_ROT_0(X, Y, _) {  (X),  (Y) },
+#define CELL_ROT_R(X, Y, _) { -(Y),  (X) },
+#define CELL_ROT_2(X, Y, _) { -(X), -(Y) },
+#define CELL_ROT_L(X, Y, _) {  (Y), -(X) },
+
+#define ROTATION_STATES(SHAPE) { { SHAPE(CELL_ROT_0, _) }, { SHAPE(CELL_ROT_R, _) }, { SHAPE(CELL_ROT_2, _) }, { SHAPE(CELL_ROT_L, _) } }
+#define FIXED_STATES(SHAPE)    { { SHAPE(CELL_ROT_0, _) }, { SHAPE(CELL_ROT_0, _) }, { SHAPE(CELL_ROT_0, _) }, { SHAPE(CELL_ROT_0, _) } }
 
+// Cells of every tetromino in every rotation state, built by the preprocessor from the shapes above
+static const RotationCells SRS_CELLS = {
+  FIXED_STATES(SHAPE_O), // the O piece doesn't rotate in SRS
+  ROTATION_STATES(SHAPE_I),
+  ROTATION_STATES(SHAPE_J),
+  ROTATION_STATES(SHAPE_L),
+  ROTATION_STATES(SHAPE_S),
+  ROTATION_STATES(SHAPE_Z),
+  ROTATION_STATES(SHAPE_T)
 };
 
-typedef GPoint KickTable[4][5];
+// Same rotations, but each cell only sets its bit if it lies on row DY of the mask
+#define MASK_CELL(X, Y, DY) | (((Y) == (DY)) << ((X) + PIECE_MASK_CENTER))
+#define MASK_ROT_0(X, Y, DY) MASK_CELL( (X),  (Y), DY)
+#define MASK_ROT_R(X, Y, DY) MASK_CELL(-(Y),  (X), DY)
+#define MASK_ROT_2(X, Y, DY) MASK_CELL(-(X), -(Y), DY)
+#define MASK_ROT_L(X, Y, DY) MASK_CELL( (Y), -(X), DY)
 
-// offset data from SRS obtained thanks to https://tetris.wiki/Super_Rotation_System#How_Guideline_SRS_Really_Works
-const KickTable JLSTZ_KICKS = { // ROTATION / OFFSET
-  { // rot 0
-    { 0, 0},
-    { 0, 0},
-    { 0, 0},
-    { 0, 0},
-    { 0, 0}
-  },
-  { // rot R
-    { 0, 0},
-    { 1, 0},
-    { 1, 1},
-    { 0,-2},
-    { 1,-2}
-  },
-  { // rot 2
-    { 0, 0},
-    { 0, 0},
-    { 0, 0},
-    { 0, 0},
-    { 0, 0}
-  },
-  { // rot L
-    { 0, 0},
-    {-1, 0},
-    {-1, 1},
-    { 0,-2},
-    {-1,-2}
-  }
+#define MASK_ROWS(SHAPE, ROT) { (0 SHAPE(ROT, -2)), (0 SHAPE(ROT, -1)), (0 SHAPE(ROT, 0)), (0 SHAPE(ROT, 1)), (0 SHAPE(ROT, 2)) }
+#define ROTATION_MASKS(SHAPE) { MASK_ROWS(SHAPE, MASK_ROT_0), MASK_ROWS(SHAPE, MASK_ROT_R), MASK_ROWS(SHAPE, MASK_ROT_2), MASK_ROWS(SHAPE, MASK_ROT_L) }
+#define FIXED_MASKS(SHAPE)    { MASK_ROWS(SHAPE, MASK_ROT_0), MASK_ROWS(SHAPE, MASK_ROT_0), MASK_ROWS(SHAPE, MASK_ROT_0), MASK_ROWS(SHAPE, MASK_ROT_0) }
+
+// Row masks of every tetromino in every rotation state, for collision tests against the grid rows.
+// The mask is centered on the pivot like the grid rows are offset by their walls, so they line up once shifted by the pivot x.
+static const RotationMasks SRS_MASKS = {
+  FIXED_MASKS(SHAPE_O),
+  ROTATION_MASKS(SHAPE_I),
+  ROTATION_MASKS(SHAPE_J),
+  ROTATION_MASKS(SHAPE_L),
+  ROTATION_MASKS(SHAPE_S),
+  ROTATION_MASKS(SHAPE_Z),
+  ROTATION_MASKS(SHAPE_T)
 };
 
-const KickTable I_KICKS = {
-  { // rot 0
-    { 0, 0},
-    {-1, 0},
-    { 2, 0},
-    {-1, 0},
-    { 2, 0}
-  },
-  { // rot R
-    {-1, 0},
-    { 0, 0},
-    { 0, 0},
-    { 0,-1},
-    { 0, 2}
-  },
-  { // rot 2
-    {-1,-1},
-    { 1,-1},
-    {-2,-1},
-    { 1, 0},
-    {-2, 0}
-  },
-  { // rot L
-    { 0,-1},
-    { 0,-1},
-    { 0,-1},
-    { 0, 1},
-    { 0,-2}
-  }
+// offset data from SRS obtained thanks to https://tetris.wiki/Super_Rotation_System#How_Guideline_SRS_Really_Works
+// 5 offsets (X, Y) per rotation state
+#define JLSTZ_OFFSETS_0  0, 0,   0, 0,   0, 0,   0, 0,   0, 0
+#define JLSTZ_OFFSETS_R  0, 0,   1, 0,   1, 1,   0,-2,   1,-2
+#define JLSTZ_OFFSETS_2  0, 0,   0, 0,   0, 0,   0, 0,   0, 0
+#define JLSTZ_OFFSETS_L  0, 0,  -1, 0,  -1, 1,   0,-2,  -1,-2
+
+#define I_OFFSETS_0      0, 0,  -1, 0,   2, 0,  -1, 0,   2, 0
+#define I_OFFSETS_R     -1, 0,   0, 0,   0, 0,   0,-1,   0, 2
+#define I_OFFSETS_2     -1,-1,   1,-1,  -2,-1,   1, 0,  -2, 0
+#define I_OFFSETS_L      0,-1,   0,-1,   0,-1,   0, 1,   0,-2
+
+// The kick to try when going from a rotation state to another is the difference of their offsets,
+// see https://harddrop.com/wiki/SRS#How_guideline_SRS_actually_works
+#define KICKS(FROM, TO) KICKS_(FROM, TO) // expands the offset lists into 20 arguments
+#define KICKS_(...) KICKS__(__VA_ARGS__)
+#define KICKS__(fx0, fy0, fx1, fy1, fx2, fy2, fx3, fy3, fx4, fy4, tx0, ty0, tx1, ty1, tx2, ty2, tx3, ty3, tx4, ty4) \
+  { { (fx0)-(tx0), (fy0)-(ty0) }, { (fx1)-(tx1), (fy1)-(ty1) }, { (fx2)-(tx2), (fy2)-(ty2) }, \
+    { (fx3)-(tx3), (fy3)-(ty3) }, { (fx4)-(tx4), (fy4)-(ty4) } }
+
+#define KICKS_FROM(OFFSETS, FROM) { KICKS(OFFSETS##_##FROM, OFFSETS##_0), KICKS(OFFSETS##_##FROM, OFFSETS##_R), \
+                                    KICKS(OFFSETS##_##FROM, OFFSETS##_2), KICKS(OFFSETS##_##FROM, OFFSETS##_L) }
+#define KICK_TRANSITIONS(OFFSETS) { KICKS_FROM(OFFSETS, 0), KICKS_FROM(OFFSETS, R), KICKS_FROM(OFFSETS, 2), KICKS_FROM(OFFSETS, L) }
+
+static const KickTable JLSTZ_KICKS = KICK_TRANSITIONS(JLSTZ_OFFSETS);
+static const KickTable I_KICKS     = KICK_TRANSITIONS(I_OFFSETS);
+
+const RotationSystem SRS_ROTATION_SYSTEM = {
+  .cells = &SRS_CELLS,
+  .masks = &SRS_MASKS,
+  .kicks = { &JLSTZ_KICKS, &I_KICKS, &JLSTZ_KICKS, &JLSTZ_KICKS, &JLSTZ_KICKS, &JLSTZ_KICKS, &JLSTZ_KICKS } // O, I, J, L, S, Z, T
 };
 
+// Swap this to play with another rotation system
+static const RotationSystem *s_rotation_system = &SRS_ROTATION_SYSTEM;
+
 void make_block (GPoint *create_block, int type, int bX, int bY) {
+  const GPoint *cells = (*s_rotation_system->cells)[type][0];
   for (int i = 0; i < 4; i++) {
-    create_block[i] = GPoint(bX + SHAPES[type][i].x, bY + SHAPES[type][i].y);
+    create_block[i] = GPoint(bX + cells[i].x, bY + cells[i].y);
   }
 }
 
-GPoint rotate_point (int old_x, int old_y, int rotation) {
-  
-  int new_x, new_y;
+// Cells of the piece on the grid
+void piece_get_cells (Piece *piece, GPoint cells[4]) {
+  const GPoint *offsets = (*s_rotation_system->cells)[piece->type][piece->rotation];
+  for (int i = 0; i < 4; i++) {
+    cells[i] = GPoint(piece->x + offsets[i].x, piece->y + offsets[i].y);
+  }
+}
 
-  switch (rotation % 4) {
-    case 0: new_x =  old_x; new_y =  old_y; break; // initial state
-    case 1: new_x = -old_y; new_y =  old_x; break;
-    case 2: new_x = -old_x; new_y = -old_y; break;
-    case 3: new_x =  old_y; new_y = -old_x; break;
-    default: new_x = old_x; new_y =  old_y;
-  } 
+void grid_init (Grid *grid) {
+  for (int j=0; j<GAME_GRID_TOTAL_HEIGHT + GRID_FLOOR_ROWS; j++) {
+    grid->row_index[j] = j;
+    grid->rows[j] = (j < GAME_GRID_TOTAL_HEIGHT) ? GRID_ROW_EMPTY : GRID_ROW_FULL;
+  }
+  memset(grid->colors, GRID_CELL_EMPTY, sizeof(grid->colors));
+  memset(grid->column_top, GAME_GRID_BLOCK_HEIGHT, sizeof(grid->column_top));
+}
 
-  return GPoint(new_x, new_y);
+void grid_set_cell (Grid *grid, int x, int y, uint8_t block_type) {
+  GRID_ROW(grid, y) |= GRID_CELL_BIT(x);
+  GRID_ROW_COLORS(grid, y)[x] = block_type;
+  if (y < grid->column_top[x]) { grid->column_top[x] = y; }
+}
 
+bool grid_row_is_full (uint16_t row) {
+  return row == GRID_ROW_FULL;
 }
 
-// Rotate the current tetromino.
-void rotate_mino(GPoint *new_block, GPoint *old_block, int block_type, int rotation) {
-  GPoint pivot_point = old_block[0]; // the 1 block out of 4 that never rotates
-  new_block[0] = pivot_point;
-  
-  for(int i=1; i<4; i++){
-    GPoint new_coord = rotate_point(SHAPES[block_type][i].x, SHAPES[block_type][i].y, rotation);
-    new_block[i] = GPoint(pivot_point.x+new_coord.x, pivot_point.y+new_coord.y);
+// Is the piece, moved by (dx, dy), out of the grid or overlapping a locked cell?
+// Cells above the buffer zone (y < GRID_TOP_ROW) are allowed and only collide with the walls.
+bool grid_collides (Piece *piece, int dx, int dy, Grid *grid) {
+  int x = piece->x + dx;
+  int y = piece->y + dy;
+  // The pivot is a cell of the piece: past the sides or the bottom it collides for sure,
+  // and inside the grid the walls & floor rows catch every other cell.
+  if (x < 0 || x >= GAME_GRID_BLOCK_WIDTH || y >= GAME_GRID_BLOCK_HEIGHT) { return true; }
+
+  const uint8_t *mask = (*s_rotation_system->masks)[piece->type][piece->rotation];
+  y -= PIECE_MASK_CENTER;
+  for (int i=0; i<PIECE_MASK_ROWS; i++, y++) {
+    uint16_t row = (y < GRID_TOP_ROW) ? GRID_ROW_EMPTY : GRID_ROW(grid, y);
+    if (((uint16_t)mask[i] << x) & row) { return true; }
   }
+  return false;
+}
 
+// Only the rows a just-locked piece touches can have become full.
+// Fills full_rows (sorted top to bottom) and returns how many there are.
+int grid_find_full_rows (Piece *piece, Grid *grid, int8_t full_rows[4]) {
+  const GPoint *offsets = (*s_rotation_system->cells)[piece->type][piece->rotation];
+  int count = 0;
+  for (int i=0; i<4; i++) {
+    int8_t y = piece->y + offsets[i].y;
+    if (y < GRID_TOP_ROW || y >= GAME_GRID_BLOCK_HEIGHT || !grid_row_is_full(GRID_ROW(grid, y))) { continue; }
+
+    // insert in order, skipping rows already found through another cell of the piece
+    int j = count;
+    while (j > 0 && full_rows[j-1] > y) { j--; }
+    if (j > 0 && full_rows[j-1] == y) { continue; }
+    memmove(&full_rows[j+1], &full_rows[j], (count - j) * sizeof(full_rows[0]));
+    full_rows[j] = y;
+    count++;
+  }
+  return count;
 }
 
-bool rotate_try_kicks(GPoint *new_block, GPoint *old_block, int block_type, int old_rotation, int new_rotation, bool grid[GAME_GRID_BLOCK_WIDTH][GAME_GRID_BLOCK_HEIGHT]){
-  const KickTable *kick_registry = (block_type == I) ? &I_KICKS : &JLSTZ_KICKS;
+// Remove the given rows (sorted top to bottom). Only the row index table is compacted,
+// the freed physical rows are emptied and recycled as the new top rows.
+void grid_clear_rows (Grid *grid, int8_t *rows, int count) {
+  if (count == 0) { return; }
 
-  // look through each offset option
-  for(int i=0; i<5; i++){ 
-    // get temp mino from old_block
-    GPoint mino_try[4];
-    memcpy(mino_try, old_block, sizeof(mino_try));
-    // look through each block of the temp mino
-    for(int j=0; j<4; j++){ 
-      // apply kick offset to each block, see https://harddrop.com/wiki/SRS#How_guideline_SRS_actually_works
-      mino_try[j].x += (*kick_registry)[old_rotation][i].x - (*kick_registry)[new_rotation][i].x;
-      mino_try[j].y += (*kick_registry)[old_rotation][i].y - (*kick_registry)[new_rotation][i].y;
-
-      // is it in bounds?
-      if(mino_try[j].x < 0) { break; } // Removed restriction on pieces going beyond top of game grid (y<0)
-      if(mino_try[j].x >= GAME_GRID_BLOCK_WIDTH || mino_try[j].y >= GAME_GRID_BLOCK_HEIGHT) { break; }
-
-      // is it overlapping anything else
-      if(grid[mino_try[j].x][mino_try[j].y]) { break; }
-
-      // if we're still here after all this, then it's all right!
-      if(j == 3) { 
-        for (int k = 0; k < 4; k++) {
-          new_block[k] = mino_try[k];
-        }
-        return true;
-      }
+  uint8_t freed[4];
+  int next_cleared = count - 1;
+  int write = rows[next_cleared];
+  for (int read = write; read >= GRID_TOP_ROW; read--) {
+    if (next_cleared >= 0 && read == rows[next_cleared]) { 
+      freed[next_cleared--] = GRID_ROW_INDEX(grid, read);
+      continue; 
     }
+    GRID_ROW_INDEX(grid, write--) = GRID_ROW_INDEX(grid, read);
+  }
+
+  for (int i=0; i<count; i++) {
+    GRID_ROW_INDEX(grid, GRID_TOP_ROW + i) = freed[i];
+    grid->rows[freed[i]] = GRID_ROW_EMPTY;
+    memset(grid->colors[freed[i]], GRID_CELL_EMPTY, GAME_GRID_BLOCK_WIDTH);
+  }
+
+  // Cleared rows are full, so every column reaches at least the top one.
+  // Columns above it just sink, the others are scanned down for their new top.
+  for (int x=0; x<GAME_GRID_BLOCK_WIDTH; x++) {
+    if (grid->column_top[x] < rows[0]) {
+      grid->column_top[x] += count;
+      continue;
+    }
+    int y = GRID_TOP_ROW + count;
+    while (y < GAME_GRID_BLOCK_HEIGHT && !(GRID_ROW(grid, y) & GRID_CELL_BIT(x))) { y++; }
+    grid->column_top[x] = y;
   }
-  // if nothing came out of this we still need to do something about new_block or else the compiler gets angry at me
-  new_block = NULL;
-  return false;
 }
 
-int find_max_drop (GPoint *block, bool grid[GAME_GRID_BLOCK_WIDTH][GAME_GRID_BLOCK_HEIGHT]) {
-  bool canDrop = true;
-  int drop_amount = 0;
+// Rotate the piece to its new rotation state, using the first kick that fits
+bool rotate_try_kicks(Piece *piece, int new_rotation, Grid *grid){
+  const GPoint *kicks = (*s_rotation_system->kicks[piece->type])[piece->rotation][new_rotation];
+  Piece rotated = *piece;
+  rotated.rotation = new_rotation;
+
+  // look through each kick option
+  for(int i=0; i<5; i++){ 
+    // is it in bounds and not overlapping anything else?
+    if (grid_collides(&rotated, kicks[i].x, kicks[i].y, grid)) { continue; }
+
+    // if we're still here after all this, then it's all right!
+    rotated.x += kicks[i].x;
+    rotated.y += kicks[i].y;
+    *piece = rotated;
+    return true;
+  }
+  return false;
+}
 
-  while (canDrop) {
-    for (int i=0; i<4; i++) {
-      int benthic = block[i].y + 1 + drop_amount;
-      if (benthic > 19 || grid[block[i].x][benthic]) { 
-        canDrop = false; 
+// The drop is the smallest gap between a cell and the top of its column.
+// If a cell is tucked under an overhang there's no such gap, so search row by row instead.
+int find_max_drop (Piece *piece, Grid *grid) {
+  const GPoint *offsets = (*s_rotation_system->cells)[piece->type][piece->rotation];
+  int drop_amount = INT8_MAX; // any gap is smaller
+  for (int i=0; i<4; i++) {
+    int gap = grid->column_top[piece->x + offsets[i].x] - (piece->y + offsets[i].y) - 1;
+    if (gap < 0) {
+      drop_amount = 0;
+      while (!grid_collides(piece, 0, drop_amount + 1, grid)) {
+        drop_amount += 1;
       }
+      return drop_amount;
     }
-    if (canDrop) {
-      drop_amount += 1;
-    }
+    if (gap < drop_amount) { drop_amount = gap; }
   }
-
   return drop_amount;
 }
 
-int find_max_horiz_move (GPoint *block, bool grid[GAME_GRID_BLOCK_WIDTH][GAME_GRID_BLOCK_HEIGHT], int direction) {
-  bool can_move = true;
+int find_max_horiz_move (Piece *piece, Grid *grid, int direction) {
   int move_amount = 0;
-  while (can_move) {
-    for (int i=0; i<4; i++) {
-      int side = block[i].x + direction * (1 + move_amount);
-      if (side < 0 || side > 9) { can_move = false; }
-      if (grid[side][block[i].y]) { can_move = false; }
-    }
-    if (can_move) {
-      move_amount += 1;
-    }
+  while (!grid_collides(piece, direction * (move_amount + 1), 0, grid)) {
+    move_amount += 1;
   }
   return move_amount;
 }
@@ -229,6 +264,8 @@ int next_block_offset (int block_type) {
   else { return 0; }
 }
 
+GridLines theme_grid_lines = { .cell_size = BLOCK_SIZE, .stroke = 1 };
+
 void set_theme(int theme_id) {
   // Load themes from the raw data (generated with the Python script from the json files in the themes folder)
   #ifdef PBL_COLOR
@@ -242,4 +279,61 @@ void set_theme(int theme_id) {
     theme.window_label_bg_inactive_color = GColorLightGray;
     theme.grid_bg_color = GColorWhite;
   #endif
+
+  // Built again with the new lines color next time it's drawn, kept if the color is the same
+  #ifdef PBL_COLOR
+    if (!gcolor_equal(theme_grid_lines.color, theme.grid_lines_color)) {
+      theme_grid_lines.color = theme.grid_lines_color;
+      grid_lines_destroy(&theme_grid_lines);
+    }
+  #endif
+}
+
+static void prv_grid_lines_build(GridLines *lines) {
+  int size = lines->cell_size * 2;
+  lines->pattern = gbitmap_create_blank(GSize(size, size), PBL_IF_COLOR_ELSE(GBitmapFormat8Bit, GBitmapFormat1Bit));
+  if (!lines->pattern) { return; }
+  lines->tile = gbitmap_create_as_sub_bitmap(lines->pattern, GRect(0, 0, lines->cell_size, lines->cell_size));
+
+  uint8_t *data = gbitmap_get_data(lines->pattern);
+  uint16_t stride = gbitmap_get_bytes_per_row(lines->pattern);
+  #ifdef PBL_BW
+    memset(data, 0xFF, stride * size); // white leaves the screen as it is
+  #endif
+
+  for (int y=0; y<size; y++) {
+    for (int x=0; x<size; x++) {
+      // Distance past the closest line, the stroke starts stroke/2 pixels before it
+      int from_x = (x + lines->stroke / 2) % lines->cell_size;
+      int from_y = (y + lines->stroke / 2) % lines->cell_size;
+      if (from_x >= lines->stroke && from_y >= lines->stroke) { continue; }
+
+      #ifdef PBL_COLOR
+        data[y * stride + x] = lines->color.argb;
+      #else
+        data[y * stride + x / 8] &= ~(1 << (x % 8));
+      #endif
+    }
+  }
+}
+
+// Draw the lines over the rect, the first vertical and horizontal ones first_line pixels into it
+void grid_lines_draw(GridLines *lines, GContext *ctx, GRect rect, GPoint first_line) {
+  if (!lines->pattern) { prv_grid_lines_build(lines); }
+  if (!lines->tile) { return; }
+
+  // The tile repeats from the rect origin, start it where the pattern is as far from its lines
+  int size = lines->cell_size;
+  gbitmap_set_bounds(lines->tile, GRect((size - first_line.x % size) % size, (size - first_line.y % size) % size, size, size));
+
+  graphics_context_set_compositing_mode(ctx, PBL_IF_COLOR_ELSE(GCompOpSet, GCompOpAnd));
+  graphics_draw_bitmap_in_rect(ctx, lines->tile, rect);
+  graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+}
+
+void grid_lines_destroy(GridLines *lines) {
+  if (lines->tile) { gbitmap_destroy(lines->tile); }
+  if (lines->pattern) { gbitmap_destroy(lines->pattern); }
+  lines->tile = NULL;
+  lines->pattern = NULL;
 }
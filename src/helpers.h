@@ -7,10 +7,40 @@
 #define LEFT -1
 #define RIGHT 1
 
-#define GAME_GRID_BLOCK_WIDTH 10
-#define GAME_GRID_BLOCK_HEIGHT 20
+// Board size, the engine is specialised for it at compile time (override with build flags).
+// Above the GAME_GRID_BLOCK_HEIGHT visible rows sits a hidden buffer where blocks can still lock,
+// its rows have negative y so the visible field keeps rows 0 to GAME_GRID_BLOCK_HEIGHT - 1.
+#ifndef GAME_GRID_BLOCK_WIDTH
+  #define GAME_GRID_BLOCK_WIDTH 10
+#endif
+#ifndef GAME_GRID_BLOCK_HEIGHT
+  #define GAME_GRID_BLOCK_HEIGHT 20
+#endif
+#ifndef GAME_GRID_BUFFER_HEIGHT
+  #ifdef PBL_PLATFORM_EMERY
+    #define GAME_GRID_BUFFER_HEIGHT 20 // 10x40 board like the guideline, there's memory to spare
+  #else
+    #define GAME_GRID_BUFFER_HEIGHT 2
+  #endif
+#endif
+#define GAME_GRID_TOTAL_HEIGHT (GAME_GRID_BUFFER_HEIGHT + GAME_GRID_BLOCK_HEIGHT)
+#define GRID_TOP_ROW (-GAME_GRID_BUFFER_HEIGHT)
+
+// Each row of the game grid is a bitmask, bit (x + GRID_WALL_BITS) set = cell (x, row) occupied.
+// The bits on both sides of the grid are always set and act as walls, and GRID_FLOOR_ROWS full rows
+// sit below the grid, so a piece mask can be tested against the rows without any bounds check.
+#define GRID_WALL_BITS 2
+#define GRID_FLOOR_ROWS 2
+#define GRID_CELL_BIT(x) (1 << ((x) + GRID_WALL_BITS))
+#define GRID_ROW_FULL  0xFFFF
+#define GRID_ROW_EMPTY ((uint16_t)~(((1 << GAME_GRID_BLOCK_WIDTH) - 1) << GRID_WALL_BITS)) // 0xF003
+#define GRID_CELL_EMPTY 255
+
+#if GAME_GRID_BLOCK_WIDTH + 2 * GRID_WALL_BITS > 16
+  #error "The grid rows can't fit the board width and its walls"
+#endif
 
-#define GAME_SAVE_VERSION  2
+#define GAME_SAVE_VERSION  6
 
 #define GAME_SAVE_VERSION_KEY  737
 #define GAME_STATE_KEY         737415
@@ -20,6 +50,12 @@
 #define GAME_SETTINGS_KEY      737415537
 #define GAME_SCORES_KEY        737415560
 #define GAME_NAME_KEY          737415561
+#define GAME_SPRINT_SCORES_KEY 737415562
+#define GAME_ULTRA_SCORES_KEY  737415563
+
+// The grid colors don't fit in a single key, they are split over the keys following GAME_GRID_COLOR_KEY
+#define GAME_GRID_COLOR_ROWS_PER_KEY (PERSIST_DATA_MAX_LENGTH / GAME_GRID_BLOCK_WIDTH)
+#define GAME_GRID_COLOR_KEYS ((GAME_GRID_TOTAL_HEIGHT + GAME_GRID_COLOR_ROWS_PER_KEY - 1) / GAME_GRID_COLOR_ROWS_PER_KEY)
 
 #ifdef PBL_PLATFORM_EMERY
   #define BLOCK_SIZE 11
@@ -38,11 +74,80 @@ typedef enum {
    BLOCK_TYPES
 } Tetromino;
 
+// The falling block: its cells are derived from the rotation tables when needed
+typedef struct {
+  int8_t  type;     // Tetromino, NONE when there's no block
+  uint8_t rotation;
+  int8_t  x;        // pivot cell on the grid
+  int8_t  y;
+} Piece;
+
+// Rows are stored physically in any order and addressed through row_index,
+// so clearing a line only rotates indices instead of moving cell data.
+typedef struct {
+  uint8_t  row_index[GAME_GRID_TOTAL_HEIGHT + GRID_FLOOR_ROWS];  // logical row (0 = top of the buffer) -> physical row
+  uint16_t rows[GAME_GRID_TOTAL_HEIGHT + GRID_FLOOR_ROWS];       // occupancy bitmask of each physical row, walls included
+  uint8_t  colors[GAME_GRID_TOTAL_HEIGHT][GAME_GRID_BLOCK_WIDTH]; // block type of each cell, GRID_CELL_EMPTY if none
+  int8_t   column_top[GAME_GRID_BLOCK_WIDTH];                    // y of the highest cell of each column, GAME_GRID_BLOCK_HEIGHT if empty
+} Grid;
+
+// Rows are addressed by their y on the board, from GRID_TOP_ROW (hidden) to GAME_GRID_BLOCK_HEIGHT - 1
+#define GRID_ROW_INDEX(grid, y)  ((grid)->row_index[(y) - GRID_TOP_ROW])
+#define GRID_ROW(grid, y)        ((grid)->rows[GRID_ROW_INDEX(grid, y)])
+#define GRID_ROW_COLORS(grid, y) ((grid)->colors[GRID_ROW_INDEX(grid, y)])
+
+// A piece mask spans the 5 rows around the pivot (dy = -2..2), bit (dx + 2) set = cell at (dx, dy).
+// Shifted left by the pivot x it lines up with the grid rows.
+#define PIECE_MASK_ROWS 5
+#define PIECE_MASK_CENTER 2
+
+typedef GPoint RotationCells[BLOCK_TYPES][4][4];                // [type][rotation][cell], offsets from the pivot
+typedef uint8_t RotationMasks[BLOCK_TYPES][4][PIECE_MASK_ROWS]; // [type][rotation][row], see PIECE_MASK_ROWS
+typedef GPoint KickTable[4][4][5];                              // [from rotation][to rotation][test], offsets to try in order
+
+typedef struct {
+  const RotationCells *cells;
+  const RotationMasks *masks;
+  const KickTable *kicks[BLOCK_TYPES];
+} RotationSystem;
+
+// Marathon goes on until the stack tops out, Sprint until 40 lines are cleared, Ultra for 2 minutes
+typedef enum {
+  GameModeMarathon,
+  GameModeSprint,
+  GameModeUltra,
+  GAME_MODES
+} GameMode;
+
+// How SELECT hard drops
+typedef enum {
+  HardDropHold,      // long press, a short one rotates on release
+  HardDropQuickHold, // same with a shorter long press
+  HardDropChord,     // press while soft dropping (UP+DOWN held), any other press rotates at once
+  HARD_DROP_MODES
+} HardDropMode;
+
+// What holds the block on BACK, touch screens also hold with a tap
+typedef enum {
+  HoldInputOff,
+  HoldInputDoubleBack, // press BACK twice, a single press pauses a moment later
+  HoldInputChord,      // press BACK while holding UP or DOWN
+  HOLD_INPUTS
+} HoldInput;
+
 typedef struct {
   bool set_drop_shadow;
   bool set_counterclockwise;
   bool set_backlight;
   uint8_t set_theme;
+  uint16_t set_das; // ms a move button is held before the block auto-shifts
+  uint16_t set_arr; // ms between auto-shift moves, 0 = straight to the wall
+  uint8_t set_soft_drop_factor; // gravity multiplier while soft dropping
+  uint8_t set_hard_drop; // HardDropMode
+  uint16_t set_entry_delay;      // ms between a block locking and the next one appearing (ARE)
+  uint16_t set_line_clear_delay; // extra ms when the block cleared rows
+  uint8_t set_hold_input; // HoldInput
+  uint8_t set_game_mode;  // GameMode of new games
 } GameSettings;
 
 typedef struct {
@@ -62,8 +167,22 @@ typedef struct {
   #endif
 } Theme;
 
+// Grid lines rasterised once into a pattern, then blitted over a whole area instead of drawn line by line.
+// The pattern is built on first use, call grid_lines_destroy() to rebuild it after changing the color.
+// On black and white it's combined with what's below, so only black lines show.
+typedef struct {
+  uint8_t cell_size;
+  uint8_t stroke;   // width of the lines, centered on them like graphics_draw_line()
+  GColor color;
+  GBitmap *pattern; // 2x2 cells, lines along the top and left of each cell
+  GBitmap *tile;    // one cell of the pattern, bounds moved to line it up with the area
+} GridLines;
+
+extern const RotationSystem SRS_ROTATION_SYSTEM;
+
 extern GameSettings game_settings;
 extern Theme theme;
+extern GridLines theme_grid_lines; // BLOCK_SIZE cells in theme.grid_lines_color
 
 extern GFont s_font_mono_line;
 extern GFont s_font_mono;
@@ -74,16 +193,32 @@ void update_string_num_layer (char* str_in, int num, char* str_out, size_t out_s
 
 void make_block (GPoint *create_block, int type, int bX, int bY);
 
-void rotate_mino(GPoint *new_block, GPoint *old_block, int block_type, int rotation);
+void piece_get_cells (Piece *piece, GPoint cells[4]);
+
+void grid_init (Grid *grid);
 
-bool rotate_try_kicks(GPoint *new_block, GPoint *old_block, int block_type, int old_rotation, int new_rotation, bool grid[GAME_GRID_BLOCK_WIDTH][GAME_GRID_BLOCK_HEIGHT]);
+void grid_set_cell (Grid *grid, int x, int y, uint8_t block_type);
 
-int find_max_drop (GPoint *block, bool grid[GAME_GRID_BLOCK_WIDTH][GAME_GRID_BLOCK_HEIGHT]);
+bool grid_row_is_full (uint16_t row);
 
-int find_max_horiz_move (GPoint *block, bool grid[GAME_GRID_BLOCK_WIDTH][GAME_GRID_BLOCK_HEIGHT], int direction);
+bool grid_collides (Piece *piece, int dx, int dy, Grid *grid);
+
+int grid_find_full_rows (Piece *piece, Grid *grid, int8_t full_rows[4]);
+
+void grid_clear_rows (Grid *grid, int8_t *rows, int count);
+
+bool rotate_try_kicks(Piece *piece, int new_rotation, Grid *grid);
+
+int find_max_drop (Piece *piece, Grid *grid);
+
+int find_max_horiz_move (Piece *piece, Grid *grid, int direction);
 
 int next_block_offset (int block_type);
 
 void set_theme(int theme);
 
+void grid_lines_draw(GridLines *lines, GContext *ctx, GRect rect, GPoint first_line);
+
+void grid_lines_destroy(GridLines *lines);
+
 #endif
@@ -87,6 +87,7 @@ GFont s_font_menu;
 static Window *s_window;
 
 static Layer *s_title_pane_layer = NULL;
+static GridLines s_menu_grid_lines = { .cell_size = MENU_GRID_BLOCK_SIZE, .stroke = MENU_GRID_STROKE };
 
 static GBitmap *s_menu_title_bitmap;
 static BitmapLayer *s_menu_title_bitmap_layer;
@@ -131,7 +132,7 @@ static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
       break;
     case 2:
       all_scores_window_push();
-      // new_score_window_push(1000, 1); // for testing
+      // new_score_window_push(GameModeMarathon, 1000, 1); // for testing
       break;
     case 3:
       settings_window_push();
@@ -186,9 +187,6 @@ static void draw_title_pane(Layer *layer, GContext *ctx) {
   graphics_context_set_fill_color(ctx, GColorDarkGray);
   graphics_fill_rect(ctx, GRect(0, grid_origin_y, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT - grid_origin_y), 0, GCornerNone);
 
-  graphics_context_set_stroke_color(ctx, GColorBlack);
-  graphics_context_set_stroke_width(ctx, MENU_GRID_STROKE);
-    
   #ifdef PBL_COLOR
     if(menu_option >= 0){
       graphics_context_set_fill_color(ctx, theme.block_color[menu_option]);
@@ -196,14 +194,9 @@ static void draw_title_pane(Layer *layer, GContext *ctx) {
     }
   #endif
 
-  // vertical lines
-  for (int i=MENU_GRID_X_OFFSET; i<=PBL_DISPLAY_WIDTH; i+=MENU_GRID_BLOCK_SIZE) {
-    graphics_draw_line(ctx, GPoint(i, grid_origin_y), GPoint(i, PBL_DISPLAY_HEIGHT)); 
-  }
-  // horizontal lines
-  for (int i=grid_origin_y; i<=PBL_DISPLAY_HEIGHT; i+=MENU_GRID_BLOCK_SIZE) {
-    graphics_draw_line(ctx, GPoint(0, i), GPoint(PBL_DISPLAY_WIDTH, i)); 
-  }
+  // grid lines, the first horizontal one on grid_origin_y
+  GRect lines = GRect(0, grid_origin_y - MENU_GRID_STROKE / 2, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT - grid_origin_y + MENU_GRID_STROKE / 2);
+  grid_lines_draw(&s_menu_grid_lines, ctx, lines, GPoint(MENU_GRID_X_OFFSET, MENU_GRID_STROKE / 2));
 
   #ifdef PBL_BW
     if(menu_option >= 0){
@@ -234,6 +227,7 @@ static void window_load(Window *window) {
 
   menu_option = can_load ? 0 : 1;
 
+  s_menu_grid_lines.color = GColorBlack;
   s_title_pane_layer = layer_create(GRect(0, 0, bounds_width, bounds_height));
   layer_set_update_proc(s_title_pane_layer, draw_title_pane);
   layer_add_child(window_layer, s_title_pane_layer);
@@ -282,6 +276,7 @@ static void window_appear(Window *window) {
 static void window_unload(Window *window) {
   // TODO / REMINDER - Add any new objects here for destruction on exit!
   layer_destroy(s_title_pane_layer);
+  grid_lines_destroy(&s_menu_grid_lines);
 
   bitmap_layer_destroy(s_menu_title_bitmap_layer);
   gbitmap_destroy(s_menu_title_bitmap);
@@ -309,12 +304,20 @@ static void init(void) {
     s_font_menu      = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_MENU_12));         // menu options
   #endif
 
-  if(!persist_exists(GAME_SETTINGS_KEY)){
-    game_settings.set_drop_shadow = true;
-    game_settings.set_counterclockwise = false;
-    game_settings.set_backlight = 0;
-    game_settings.set_theme = 0;
-  } else {
+  // Defaults first: settings saved by older versions are shorter and leave the newer ones untouched
+  game_settings.set_drop_shadow = true;
+  game_settings.set_counterclockwise = false;
+  game_settings.set_backlight = 0;
+  game_settings.set_theme = 0;
+  game_settings.set_das = 167;
+  game_settings.set_arr = 50;
+  game_settings.set_soft_drop_factor = 20;
+  game_settings.set_hard_drop = HardDropHold;
+  game_settings.set_entry_delay = 0;
+  game_settings.set_line_clear_delay = 0;
+  game_settings.set_hold_input = HoldInputOff;
+  game_settings.set_game_mode = GameModeMarathon;
+  if(persist_exists(GAME_SETTINGS_KEY)){
     persist_read_data(GAME_SETTINGS_KEY, &game_settings, sizeof(GameSettings));
   }
 
@@ -337,6 +340,7 @@ static void init(void) {
 
 static void deinit(void) {
   window_destroy(s_window);
+  grid_lines_destroy(&theme_grid_lines);
 }
 
 // --------------------------- //
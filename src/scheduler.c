@@ -0,0 +1,162 @@
+#include "scheduler.h"
+
+typedef struct {
+  SchedulerCallback callback;
+  void *data;
+  uint32_t deadline;  // scheduler_now() time to run at, or time left while paused
+  bool scheduled;
+} SchedulerJob;
+
+static SchedulerJob s_jobs[SCHEDULER_MAX_JOBS];
+static AppTimer *s_timer = NULL;
+static bool s_paused = false;
+static bool s_dispatching = false;
+
+static void prv_arm_timer();
+
+// Milliseconds since the epoch, wrapped to 32 bits: compare them through their signed difference
+uint32_t scheduler_now () {
+  time_t seconds;
+  uint16_t milliseconds;
+  time_ms(&seconds, &milliseconds);
+  return (uint32_t)seconds * 1000 + milliseconds;
+}
+
+// Time left before the deadline, 0 if it has passed
+static uint32_t prv_time_left(uint32_t deadline, uint32_t now) {
+  int32_t left = (int32_t)(deadline - now);
+  return left > 0 ? left : 0;
+}
+
+// Run every job whose deadline has passed, earliest first.
+// A job that schedules itself again with no delay runs on the next timer, not in this loop.
+static void prv_timer_callback(void *data) {
+  s_timer = NULL;
+  s_dispatching = true;
+
+  uint32_t now = scheduler_now();
+  uint32_t due = 0;
+  for (int i=0; i<SCHEDULER_MAX_JOBS; i++) {
+    if (s_jobs[i].scheduled && (int32_t)(s_jobs[i].deadline - now) <= 0) { due |= 1 << i; }
+  }
+
+  while (due && !s_paused) {
+    int next = -1;
+    for (int i=0; i<SCHEDULER_MAX_JOBS; i++) {
+      if (!(due & (1 << i))) { continue; }
+      if (next < 0 || (int32_t)(s_jobs[i].deadline - s_jobs[next].deadline) < 0) { next = i; }
+    }
+    due &= ~(1 << next);
+
+    // an earlier job may have cancelled or pushed back this one
+    if (!s_jobs[next].scheduled || (int32_t)(s_jobs[next].deadline - now) > 0) { continue; }
+
+    s_jobs[next].scheduled = false;
+    s_jobs[next].callback(s_jobs[next].data);
+  }
+
+  s_dispatching = false;
+  prv_arm_timer();
+}
+
+// Keep the timer armed for the earliest deadline, if any
+static void prv_arm_timer() {
+  if (s_dispatching) { return; } // armed once all the due jobs have run
+
+  int next = -1;
+  if (!s_paused) {
+    for (int i=0; i<SCHEDULER_MAX_JOBS; i++) {
+      if (!s_jobs[i].scheduled) { continue; }
+      if (next < 0 || (int32_t)(s_jobs[i].deadline - s_jobs[next].deadline) < 0) { next = i; }
+    }
+  }
+
+  if (next < 0) {
+    if (s_timer) {
+      app_timer_cancel(s_timer);
+      s_timer = NULL;
+    }
+    return;
+  }
+
+  uint32_t delay = prv_time_left(s_jobs[next].deadline, scheduler_now());
+  if (!s_timer || !app_timer_reschedule(s_timer, delay)) {
+    s_timer = app_timer_register(delay, prv_timer_callback, NULL);
+  }
+}
+
+void scheduler_schedule (uint8_t job, uint32_t delay_ms, SchedulerCallback callback, void *data) {
+  scheduler_schedule_at(job, scheduler_now() + delay_ms, callback, data);
+}
+
+// Schedule against an absolute scheduler_now() time, so a periodic job doesn't drift by its own run time.
+// A deadline in the past runs as soon as possible.
+void scheduler_schedule_at (uint8_t job, uint32_t deadline, SchedulerCallback callback, void *data) {
+  s_jobs[job].callback = callback;
+  s_jobs[job].data = data;
+  s_jobs[job].scheduled = true;
+  s_jobs[job].deadline = s_paused ? prv_time_left(deadline, scheduler_now()) : deadline;
+  prv_arm_timer();
+}
+
+// Last deadline of the job, still valid from its callback once it has run.
+// Deadlines frozen by a pause are moved by its duration.
+uint32_t scheduler_deadline (uint8_t job) {
+  bool frozen = s_paused && s_jobs[job].scheduled;
+  return frozen ? scheduler_now() + s_jobs[job].deadline : s_jobs[job].deadline;
+}
+
+// Move the deadline of a pending job, returns false if the job isn't pending
+bool scheduler_reschedule (uint8_t job, uint32_t delay_ms) {
+  if (!s_jobs[job].scheduled) { return false; }
+
+  s_jobs[job].deadline = s_paused ? delay_ms : scheduler_now() + delay_ms;
+  prv_arm_timer();
+  return true;
+}
+
+void scheduler_cancel (uint8_t job) {
+  if (!s_jobs[job].scheduled) { return; }
+
+  s_jobs[job].scheduled = false;
+  prv_arm_timer();
+}
+
+void scheduler_cancel_all () {
+  for (int i=0; i<SCHEDULER_MAX_JOBS; i++) {
+    s_jobs[i].scheduled = false;
+  }
+  s_paused = false;
+  prv_arm_timer();
+}
+
+bool scheduler_is_scheduled (uint8_t job) {
+  return s_jobs[job].scheduled;
+}
+
+// Freeze every deadline: pending jobs keep the time they had left, and run that much later after scheduler_resume()
+void scheduler_pause () {
+  if (s_paused) { return; }
+
+  uint32_t now = scheduler_now();
+  for (int i=0; i<SCHEDULER_MAX_JOBS; i++) {
+    if (s_jobs[i].scheduled) { s_jobs[i].deadline = prv_time_left(s_jobs[i].deadline, now); }
+  }
+  s_paused = true;
+  prv_arm_timer();
+}
+
+void scheduler_resume () {
+  if (!s_paused) { return; }
+
+  uint32_t now = scheduler_now();
+  for (int i=0; i<SCHEDULER_MAX_JOBS; i++) {
+    if (s_jobs[i].scheduled) { s_jobs[i].deadline += now; }
+  }
+  s_paused = false;
+  prv_arm_timer();
+}
+
+bool scheduler_is_paused () {
+  return s_paused;
+}
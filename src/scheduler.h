@@ -0,0 +1,35 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <pebble.h>
+
+// Deadline scheduler: every job has a fixed slot picked by the caller, so scheduling a job again
+// replaces its pending deadline instead of adding a second one.
+// Only one AppTimer is armed at a time, for the earliest deadline of all the jobs.
+#define SCHEDULER_MAX_JOBS 8
+
+typedef void (*SchedulerCallback)(void *data);
+
+uint32_t scheduler_now ();
+
+void scheduler_schedule (uint8_t job, uint32_t delay_ms, SchedulerCallback callback, void *data);
+
+void scheduler_schedule_at (uint8_t job, uint32_t deadline, SchedulerCallback callback, void *data);
+
+uint32_t scheduler_deadline (uint8_t job);
+
+bool scheduler_reschedule (uint8_t job, uint32_t delay_ms);
+
+void scheduler_cancel (uint8_t job);
+
+void scheduler_cancel_all ();
+
+bool scheduler_is_scheduled (uint8_t job);
+
+void scheduler_pause ();
+
+void scheduler_resume ();
+
+bool scheduler_is_paused ();
+
+#endif
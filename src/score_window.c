@@ -27,6 +27,15 @@ static int  s_new_score_pos = MAX_SCORES_SHOWN;
 
 static bool s_showing_details = false;
 
+// Each game mode has its own table: Marathon and Ultra rank the score, Sprint the time in ms (lower is better)
+static uint8_t s_mode = GameModeMarathon;
+static const uint32_t SCORES_KEYS[GAME_MODES] = { GAME_SCORES_KEY, GAME_SPRINT_SCORES_KEY, GAME_ULTRA_SCORES_KEY };
+static char *HEADER_LABELS[GAME_MODES] = { 
+  PBL_IF_ROUND_ELSE("HIGH\nSCORES", "HIGH SCORE"), 
+  PBL_IF_ROUND_ELSE("SPRINT\n40 LINES", "SPRINT 40L"), 
+  PBL_IF_ROUND_ELSE("ULTRA\n2 MIN", "ULTRA 2 MIN") 
+};
+
 static void prv_score_window_push();
 static void prv_window_load(Window *window);
 static void prv_window_unload(Window *window);
@@ -35,6 +44,8 @@ static void prv_draw_name_select(Layer *layer, GContext *ctx);
 static void prv_click_config_provider(void *context);
 
 static void prv_load_scores();
+static bool prv_is_better(uint32_t result, uint32_t other);
+static void prv_format_result(char *str, size_t size, uint32_t result);
 // static void prv_test_scores();
 static void prv_add_new_score();
 static char * prv_get_score_string(int i);
@@ -47,7 +58,8 @@ static void prv_show_details();
 // **** WINDOW FUNCTIONS **** //
 // -------------------------- //
 
-void new_score_window_push(uint32_t new_score, uint8_t level) {
+void new_score_window_push(uint8_t mode, uint32_t new_score, uint8_t level) {
+  s_mode = mode % GAME_MODES;
   prv_load_scores();
   // prv_test_scores();
   prv_score_window_push();
@@ -63,6 +75,7 @@ void new_score_window_push(uint32_t new_score, uint8_t level) {
 }
 
 void all_scores_window_push() {
+  s_mode = GameModeMarathon;
   prv_load_scores();
   s_new_score_pos = MAX_SCORES_SHOWN;
   prv_score_window_push();
@@ -92,7 +105,7 @@ static void prv_window_load(Window *window){
   int16_t bounds_height = bounds.size.h;
 
   s_header_layer = text_layer_create(GRect(0, 16, bounds_width, 39));
-  text_layer_set_text(s_header_layer, PBL_IF_ROUND_ELSE("HIGH\nSCORES", "HIGH SCORE"));
+  text_layer_set_text(s_header_layer, HEADER_LABELS[s_mode]);
   text_layer_set_font(s_header_layer, s_font_menu);
   text_layer_set_text_alignment(s_header_layer, GTextAlignmentCenter);
   text_layer_set_background_color(s_header_layer, GColorClear);
@@ -236,8 +249,24 @@ static void prv_select_click_handler(ClickRecognizerRef recognizer, void *contex
   }
 }
 
+// Browsing the tables, UP and DOWN switch between the game modes
+static void prv_switch_mode(int direction) {
+  s_mode = (s_mode + GAME_MODES + direction) % GAME_MODES;
+  s_new_score_pos = MAX_SCORES_SHOWN;
+  layer_remove_from_parent(text_layer_get_layer(s_bad_score_text_layer));
+  prv_load_scores();
+  text_layer_set_text(s_header_layer, HEADER_LABELS[s_mode]);
+  if(s_showing_details)
+    prv_show_details();
+  else
+    prv_show_scores();
+}
+
 static void prv_up_click_handler(ClickRecognizerRef recognizer, void *context) {
-  if(layer_get_hidden(s_name_picker_layer)) return;
+  if(layer_get_hidden(s_name_picker_layer)) {
+    prv_switch_mode(-1);
+    return;
+  }
 
   char *c = &s_new_score_name[s_current_char];
   (*c) -= 1;
@@ -247,7 +276,10 @@ static void prv_up_click_handler(ClickRecognizerRef recognizer, void *context) {
 }
 
 static void prv_down_click_handler(ClickRecognizerRef recognizer, void *context) {
-  if(layer_get_hidden(s_name_picker_layer)) return;
+  if(layer_get_hidden(s_name_picker_layer)) {
+    prv_switch_mode(1);
+    return;
+  }
 
   char *c = &s_new_score_name[s_current_char];
   (*c) += 1;
@@ -281,9 +313,10 @@ static void prv_click_config_provider(void *context) {
 // }
 
 static void prv_load_scores(){
-  if (persist_exists(GAME_SCORES_KEY)){
+  memset(s_game_scores, 0, sizeof(s_game_scores));
+  if (persist_exists(SCORES_KEYS[s_mode])){
     APP_LOG(APP_LOG_LEVEL_INFO, "Reading saved score data");
-    persist_read_data(GAME_SCORES_KEY, &s_game_scores, sizeof(s_game_scores));
+    persist_read_data(SCORES_KEYS[s_mode], &s_game_scores, sizeof(s_game_scores));
     s_scores_exist_bool = true;
   } else {
     APP_LOG(APP_LOG_LEVEL_INFO, "Found no saved score data");
@@ -292,14 +325,14 @@ static void prv_load_scores(){
 
 static void prv_show_scores(){
   for (int i=0; i<MAX_SCORES_SHOWN; i++){
-    if(s_game_scores[i].score){
+    #ifdef PBL_COLOR
+      text_layer_set_text_color(s_score_text_layer[i], i == s_new_score_pos ? theme.score_accent_color : theme.window_header_color);
+    #endif
+    if(s_game_scores[i].score)
       text_layer_set_text(s_score_text_layer[i], prv_get_score_string(i));
-      #ifdef PBL_COLOR
-        if(i == s_new_score_pos) {
-          text_layer_set_text_color(s_score_text_layer[i], theme.score_accent_color);
-        }
-      #endif
-    } else 
+    else if(!s_game_scores[0].score && i == MAX_SCORES_SHOWN/2-1)
+      text_layer_set_text(s_score_text_layer[i], "No scores yet");
+    else 
       text_layer_set_text(s_score_text_layer[i], "-");
   }
 }
@@ -320,7 +353,7 @@ static void prv_add_new_score(){
 
   int pos = MAX_SCORES_SHOWN; 
   for(int i=0; i<MAX_SCORES_SHOWN; i++){
-    if (s_new_score > s_game_scores[i].score) {
+    if (prv_is_better(s_new_score, s_game_scores[i].score)) {
       pos = i;
       break;
     }
@@ -328,7 +361,9 @@ static void prv_add_new_score(){
 
   // If it’s lower than all existing scores, show it at the bottom and stop there
   if (pos == MAX_SCORES_SHOWN) {
-    snprintf(s_bad_score_string, sizeof(s_bad_score_string), "X.%s-%06"PRIu32"", s_new_score_name, s_new_score);
+    char result[10];
+    prv_format_result(result, sizeof(result), s_new_score);
+    snprintf(s_bad_score_string, sizeof(s_bad_score_string), "X.%s-%s", s_new_score_name, result);
     text_layer_set_text(s_bad_score_text_layer, s_bad_score_string);
     layer_add_child(window_get_root_layer(s_window), text_layer_get_layer(s_bad_score_text_layer));
     return;
@@ -350,12 +385,31 @@ static void prv_add_new_score(){
 
   s_new_score_pos = pos;
 
-  persist_write_data(GAME_SCORES_KEY, &s_game_scores, sizeof(s_game_scores));
+  persist_write_data(SCORES_KEYS[s_mode], &s_game_scores, sizeof(s_game_scores));
   prv_show_scores();
 }
 
+// Whether the result ranks above the other one, an empty slot (0) ranks below everything
+static bool prv_is_better(uint32_t result, uint32_t other){
+  if(!other) { return true; }
+  if(s_mode == GameModeSprint) { return result < other; }
+  return result > other;
+}
+
+// Score on 6 digits, or Sprint time as M:SS.cc
+static void prv_format_result(char *str, size_t size, uint32_t result){
+  if(s_mode == GameModeSprint) {
+    uint32_t centiseconds = result / 10;
+    snprintf(str, size, "%d:%02d.%02d", (int)(centiseconds / 6000), (int)(centiseconds / 100 % 60), (int)(centiseconds % 100));
+    return;
+  }
+  snprintf(str, size, "%06"PRIu32"", result);
+}
+
 static char * prv_get_score_string(int i){
-  snprintf(s_game_score_strings[i], sizeof(s_game_score_strings[i]), "%d.%s-%06"PRIu32"", i+1, s_game_scores[i].name, s_game_scores[i].score);
+  char result[10];
+  prv_format_result(result, sizeof(result), s_game_scores[i].score);
+  snprintf(s_game_score_strings[i], sizeof(s_game_score_strings[i]), "%d.%s-%s", i+1, s_game_scores[i].name, result);
   // APP_LOG(APP_LOG_LEVEL_DEBUG, "score %d : %s", i, s_game_score_strings[i]);
   return s_game_score_strings[i];
 }
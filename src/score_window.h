@@ -31,5 +31,5 @@ typedef struct {
   char date[10];
 } GameScore;
 
-void new_score_window_push(uint32_t new_score, uint8_t level);
+void new_score_window_push(uint8_t mode, uint32_t new_score, uint8_t level);
 void all_scores_window_push();
\ No newline at end of file
@@ -8,8 +8,8 @@ static Window *s_window;
 static Layer     *s_select_layer;
 static Layer     *s_theme_preview_layer;
 static TextLayer *s_header_layer;
-static TextLayer *s_settings_label_layer[SETTINGS_COUNT];
-static TextLayer *s_settings_input_layer[SETTINGS_COUNT];
+static TextLayer *s_settings_label_layer[SETTINGS_VISIBLE];
+static TextLayer *s_settings_input_layer[SETTINGS_VISIBLE];
 
 static GPath     *s_selector_path; // arrow for menu select
 
@@ -18,31 +18,57 @@ static GPath     *s_selector_path; // arrow for menu select
   static GBitmap *s_bw_block_sprites[7];
 #endif
 
-static char *MENU_OPTION_LABELS[SETTINGS_COUNT] = {"Drop Shadows", "Rotation", "Backlight", "Theme"};
+enum {
+  SettingDropShadow,
+  SettingRotation,
+  SettingBacklight,
+  SettingTheme,
+  SettingDAS,
+  SettingARR,
+  SettingSoftDrop,
+  SettingHardDrop,
+  SettingEntryDelay,
+  SettingHold,
+  SettingGameMode
+};
+
+static char *MENU_OPTION_LABELS[SETTINGS_COUNT] = {"Drop Shadows", "Rotation", "Backlight", "Theme", "Auto-Shift", "Repeat", "Soft Drop", "Hard Drop", "Entry Delay", "Hold", "Game Mode"};
 
 #ifdef PBL_PLATFORM_EMERY
-  static char *MENU_INPUT_LABELS[SETTINGS_COUNT][THEMES_COUNT] = {{"OFF", "ON"}, {"Clockwise", "Counter Clock."}, {"Default", "Always ON"}, {"< 1 >", "< 2 >", "< 3 >", "< 4 >"}};
+  static char *MENU_INPUT_LABELS[SETTINGS_COUNT][SETTINGS_MAX_OPTIONS] = {{"OFF", "ON"}, {"Clockwise", "Counter Clock."}, {"Default", "Always ON"}, {"< 1 >", "< 2 >", "< 3 >", "< 4 >"}, {"267 ms", "200 ms", "167 ms", "117 ms"}, {"100 ms", "50 ms", "33 ms", "Instant"}, {"x5", "x10", "x20", "x40"}, {"Hold", "Quick Hold", "Soft + Select"}, {"OFF", "Short", "Medium", "Long"}, {"OFF", "Double Back", "Move + Back"}, {"Marathon", "Sprint 40L", "Ultra 2 min"}};
 #else
-  static char *MENU_INPUT_LABELS[SETTINGS_COUNT][THEMES_COUNT] = {{"OFF", "ON"}, {"Clockwise", "Cnt. Clock."}, {"Default", "Alw. ON"}, {"< 1 >", "< 2 >", "< 3 >", "< 4 >"}};
+  static char *MENU_INPUT_LABELS[SETTINGS_COUNT][SETTINGS_MAX_OPTIONS] = {{"OFF", "ON"}, {"Clockwise", "Cnt. Clock."}, {"Default", "Alw. ON"}, {"< 1 >", "< 2 >", "< 3 >", "< 4 >"}, {"267ms", "200ms", "167ms", "117ms"}, {"100ms", "50ms", "33ms", "Instant"}, {"x5", "x10", "x20", "x40"}, {"Hold", "Quick Hold", "Soft+Sel"}, {"OFF", "Short", "Medium", "Long"}, {"OFF", "Dbl Back", "Move+Back"}, {"Marathon", "Sprint 40L", "Ultra 2m"}};
 #endif
 
-static int MENU_INPUT_VALUES[SETTINGS_COUNT] = {0, 0, 0, 0};
+static int MENU_INPUT_COUNTS[SETTINGS_COUNT] = {2, 2, 2, THEMES_COUNT, 4, 4, 4, HARD_DROP_MODES, 4, HOLD_INPUTS, GAME_MODES};
+static int MENU_INPUT_VALUES[SETTINGS_COUNT] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// Delays in ms behind the Auto-Shift (DAS) and Repeat (ARR) options, and gravity multipliers behind Soft Drop
+static const uint16_t DAS_PRESETS[SETTINGS_MAX_OPTIONS] = {267, 200, 167, 117};
+static const uint16_t ARR_PRESETS[SETTINGS_MAX_OPTIONS] = {100, 50, 33, 0};
+static const uint16_t SOFT_DROP_PRESETS[SETTINGS_MAX_OPTIONS] = {5, 10, 20, 40};
+// Entry Delay sets both the delay before a new block and the one added after a line clear, in ms
+static const uint16_t ENTRY_DELAY_PRESETS[SETTINGS_MAX_OPTIONS] = {0, 100, 167, 267};
+static const uint16_t LINE_CLEAR_DELAY_PRESETS[SETTINGS_MAX_OPTIONS] = {0, 200, 333, 500};
 
 #ifdef PBL_ROUND
+  // per row on screen, to follow the round edge
   #ifdef PBL_PLATFORM_CHALK
-  static int MENU_OPTION_ROUND_OFFSET[SETTINGS_COUNT] = {12, 4, 12, 34};
+  static int MENU_OPTION_ROUND_OFFSET[SETTINGS_VISIBLE] = {12, 4, 12, 34};
   #elif defined(PBL_PLATFORM_GABBRO)
-  static int MENU_OPTION_ROUND_OFFSET[SETTINGS_COUNT] = {18, 6, 12, 36};
+  static int MENU_OPTION_ROUND_OFFSET[SETTINGS_VISIBLE] = {18, 6, 12, 36};
   #endif
 #endif
 
 static int current_setting = 0;
+static int first_visible_setting = 0;
 
 static AppTimer *s_timer = NULL;
 
 static void prv_window_load(Window *window);
 static void prv_window_unload(Window *window);
 
+static void prv_update_visible_settings();
 static void prv_draw_select(Layer *layer, GContext *ctx);
 static void prv_draw_theme_preview(Layer *layer, GContext *ctx);
 
@@ -50,6 +76,7 @@ static void prv_click_config_provider(void *context);
 
 static void prv_preview_hide_tick(void *data);
 
+static int prv_preset_index(const uint16_t *presets, uint16_t value);
 static void prv_load_settings();
 static void prv_save_settings();
 
@@ -88,7 +115,7 @@ static void prv_window_load(Window *window){
   text_layer_set_text_color(s_header_layer, theme.window_header_color);
   layer_add_child(window_layer, text_layer_get_layer(s_header_layer));
   
-  for (int i=0; i<SETTINGS_COUNT; i++){
+  for (int i=0; i<SETTINGS_VISIBLE; i++){
     s_settings_label_layer[i] = text_layer_create(
       GRect(
         PBL_IF_RECT_ELSE(
@@ -149,7 +176,7 @@ static void prv_window_unload(Window *window){
   text_layer_destroy(s_header_layer);
   layer_destroy(s_select_layer);
   layer_destroy(s_theme_preview_layer);
-  for (int i=0; i<SETTINGS_COUNT; i++){
+  for (int i=0; i<SETTINGS_VISIBLE; i++){
     text_layer_destroy(s_settings_label_layer[i]);
     text_layer_destroy(s_settings_input_layer[i]);
   }
@@ -163,6 +190,15 @@ static void prv_window_unload(Window *window){
   #endif
 }
 
+// Show the settings from first_visible_setting in the rows on screen
+static void prv_update_visible_settings() {
+  for (int i=0; i<SETTINGS_VISIBLE; i++){
+    int setting = first_visible_setting + i;
+    text_layer_set_text(s_settings_label_layer[i], MENU_OPTION_LABELS[setting]);
+    text_layer_set_text(s_settings_input_layer[i], MENU_INPUT_LABELS[setting][MENU_INPUT_VALUES[setting]]);
+  }
+}
+
 // ------------------------ //
 // **** DRAW FUNCTIONS **** //
 // ------------------------ //
@@ -175,7 +211,7 @@ static void prv_draw_select(Layer *layer, GContext *ctx){
   if(s_timer != NULL){
     graphics_context_set_fill_color(ctx, theme.window_label_bg_inactive_color);
   }
-  for (int i=0; i<SETTINGS_COUNT; i++){
+  for (int i=0; i<SETTINGS_VISIBLE; i++){
     // Draw label BGs separately from text layers
     graphics_fill_rect(ctx, GRect(0, SETTINGS_LABEL_TOP_Y + i * SETTINGS_LABEL_HEIGHT, PBL_DISPLAY_WIDTH, SETTINGS_LABEL_HEIGHT - SETTINGS_LABEL_DISTANCE), 0, GCornerNone);
   }
@@ -183,10 +219,11 @@ static void prv_draw_select(Layer *layer, GContext *ctx){
   graphics_context_set_fill_color(ctx, PBL_IF_COLOR_ELSE(theme.select_color, GColorBlack));
   GPoint selector[3];
   int x_off = -6;
-  int y_off = current_setting * SETTINGS_LABEL_HEIGHT;
+  int row = current_setting - first_visible_setting;
+  int y_off = row * SETTINGS_LABEL_HEIGHT;
 
   #ifdef PBL_ROUND
-  x_off += MENU_OPTION_ROUND_OFFSET[current_setting] - 2;
+  x_off += MENU_OPTION_ROUND_OFFSET[row] - 2;
   #endif
 
   #ifdef PBL_PLATFORM_EMERY
@@ -225,7 +262,7 @@ static void prv_draw_theme_preview(Layer *layer, GContext *ctx){
         graphics_fill_rect(ctx, rect, 0, GCornerNone);
       #else
         gbitmap_destroy(s_bw_block_sprites[i]);
-        s_bw_block_sprites[i] = gbitmap_create_as_sub_bitmap(s_bw_spritesheet, GRect(i*7, (MENU_INPUT_VALUES[3]*7) % (THEMES_COUNT*7), 7, 7));
+        s_bw_block_sprites[i] = gbitmap_create_as_sub_bitmap(s_bw_spritesheet, GRect(i*7, (MENU_INPUT_VALUES[SettingTheme]*7) % (THEMES_COUNT*7), 7, 7));
         graphics_context_set_stroke_color(ctx, GColorBlack);
         graphics_draw_rect(ctx, GRect(rect.origin.x, rect.origin.y, rect.size.w + 1, rect.size.h + 1));
         graphics_draw_bitmap_in_rect(ctx, s_bw_block_sprites[i], GRect(rect.origin.x + 1, rect.origin.y + 1, rect.size.w - 1, rect.size.h - 1));
@@ -234,15 +271,9 @@ static void prv_draw_theme_preview(Layer *layer, GContext *ctx){
   }
 
   #ifdef PBL_COLOR
-    graphics_context_set_stroke_color(ctx, theme.grid_lines_color);
-    // Draw vertical lines
-    for (int i=PREV_BOX_X-1+BLOCK_SIZE; i<(PBL_DISPLAY_WIDTH - PREV_BOX_X - 2); i+=BLOCK_SIZE) {
-      graphics_draw_line(ctx, GPoint(i, PREV_BOX_Y), GPoint(i, PREV_BOX_Y + PREV_BOX_H - 2)); // -2 at the end => not overlap box edge
-    }
-    // Draw horizontal lines
-    for (int i=PREV_BOX_Y+BLOCK_SIZE; i<(PREV_BOX_Y + PREV_BOX_H - 2); i+=BLOCK_SIZE) {
-      graphics_draw_line(ctx, GPoint(PREV_BOX_X, i), GPoint(PBL_DISPLAY_WIDTH - PREV_BOX_X - 2, i));
-    }
+    // -1 & -2 at the end => not overlap box edge, the lines along the top edge are drawn over by it
+    GRect lines = GRect(PREV_BOX_X, PREV_BOX_Y, background.size.w - 1, PREV_BOX_H - 1);
+    grid_lines_draw(&theme_grid_lines, ctx, lines, GPoint(BLOCK_SIZE - 1, 0));
   #endif
 
   graphics_context_set_stroke_color(ctx, PBL_IF_COLOR_ELSE(GColorWhite, GColorBlack));
@@ -258,6 +289,13 @@ static void prv_up_click_handler(ClickRecognizerRef recognizer, void *context) {
     current_setting -= 1;
   else
     current_setting = SETTINGS_COUNT - 1;
+
+  // Scroll to keep the selected setting on screen
+  if(current_setting < first_visible_setting)
+    first_visible_setting = current_setting;
+  else if(current_setting >= first_visible_setting + SETTINGS_VISIBLE)
+    first_visible_setting = current_setting - SETTINGS_VISIBLE + 1;
+  prv_update_visible_settings();
   
   layer_mark_dirty(s_select_layer);
 }
@@ -265,17 +303,13 @@ static void prv_up_click_handler(ClickRecognizerRef recognizer, void *context) {
 static void prv_select_click_handler(ClickRecognizerRef recognizer, void *context) {
   int *value_to_change = &MENU_INPUT_VALUES[current_setting];
 
-  if(current_setting < 3){
-    *value_to_change = (*value_to_change + 1) % 2;
-  } else {
-    *value_to_change = (*value_to_change + 1) % THEMES_COUNT;
-  }
+  *value_to_change = (*value_to_change + 1) % MENU_INPUT_COUNTS[current_setting];
 
-  if(current_setting == 2){
+  if(current_setting == SettingBacklight){
     light_enable(*value_to_change%2);
   }
 
-  if(current_setting == 3){
+  if(current_setting == SettingTheme){
     layer_set_hidden(s_theme_preview_layer, false);
     if(s_timer == NULL){
       s_timer = app_timer_register(1500, prv_preview_hide_tick, NULL);
@@ -284,13 +318,13 @@ static void prv_select_click_handler(ClickRecognizerRef recognizer, void *contex
     }
     set_theme(*value_to_change); 
     text_layer_set_text_color(s_header_layer, theme.window_header_color);
-    for (int i=0; i<SETTINGS_COUNT; i++){
+    for (int i=0; i<SETTINGS_VISIBLE; i++){
       text_layer_set_text_color(s_settings_label_layer[i], theme.window_label_text_color);
       text_layer_set_text_color(s_settings_input_layer[i], theme.window_label_text_color);
     }
   }
 
-  text_layer_set_text(s_settings_input_layer[current_setting], MENU_INPUT_LABELS[current_setting][*value_to_change]);
+  text_layer_set_text(s_settings_input_layer[current_setting - first_visible_setting], MENU_INPUT_LABELS[current_setting][*value_to_change]);
   // APP_LOG(APP_LOG_LEVEL_INFO, "current setting %d, value to change %d, input label = %s", current_setting, *value_to_change, MENU_INPUT_LABELS[current_setting][*value_to_change]);
 }
 
@@ -299,6 +333,14 @@ static void prv_down_click_handler(ClickRecognizerRef recognizer, void *context)
     current_setting += 1;
   else
     current_setting = 0;
+
+  // Scroll to keep the selected setting on screen
+  if(current_setting < first_visible_setting)
+    first_visible_setting = current_setting;
+  else if(current_setting >= first_visible_setting + SETTINGS_VISIBLE)
+    first_visible_setting = current_setting - SETTINGS_VISIBLE + 1;
+  prv_update_visible_settings();
+
   layer_mark_dirty(s_select_layer);
 }
 
@@ -328,21 +370,43 @@ static void prv_preview_hide_tick(void *data){
 // ***** DATA FUNCTIONS ***** //
 // -------------------------- //
 
+// Option matching a preset setting, the closest preset if it isn't one of them
+static int prv_preset_index(const uint16_t *presets, uint16_t value) {
+  int index = 0;
+  for(int i=1; i<SETTINGS_MAX_OPTIONS; i++) {
+    if(abs(presets[i] - value) < abs(presets[index] - value)) { index = i; }
+  }
+  return index;
+}
+
 static void prv_load_settings() {
-  MENU_INPUT_VALUES[0] = game_settings.set_drop_shadow % 2;
-  MENU_INPUT_VALUES[1] = game_settings.set_counterclockwise % 2;
-  MENU_INPUT_VALUES[2] = game_settings.set_backlight % 2;
-  MENU_INPUT_VALUES[3] = game_settings.set_theme % THEMES_COUNT;
+  MENU_INPUT_VALUES[SettingDropShadow] = game_settings.set_drop_shadow % 2;
+  MENU_INPUT_VALUES[SettingRotation]   = game_settings.set_counterclockwise % 2;
+  MENU_INPUT_VALUES[SettingBacklight]  = game_settings.set_backlight % 2;
+  MENU_INPUT_VALUES[SettingTheme]      = game_settings.set_theme % THEMES_COUNT;
+  MENU_INPUT_VALUES[SettingDAS]        = prv_preset_index(DAS_PRESETS, game_settings.set_das);
+  MENU_INPUT_VALUES[SettingARR]        = prv_preset_index(ARR_PRESETS, game_settings.set_arr);
+  MENU_INPUT_VALUES[SettingSoftDrop]   = prv_preset_index(SOFT_DROP_PRESETS, game_settings.set_soft_drop_factor);
+  MENU_INPUT_VALUES[SettingHardDrop]   = game_settings.set_hard_drop % HARD_DROP_MODES;
+  MENU_INPUT_VALUES[SettingEntryDelay] = prv_preset_index(ENTRY_DELAY_PRESETS, game_settings.set_entry_delay);
+  MENU_INPUT_VALUES[SettingHold]       = game_settings.set_hold_input % HOLD_INPUTS;
+  MENU_INPUT_VALUES[SettingGameMode]   = game_settings.set_game_mode % GAME_MODES;
   
-  for(int i=0; i<SETTINGS_COUNT; i++) {
-    text_layer_set_text(s_settings_input_layer[i], MENU_INPUT_LABELS[i][MENU_INPUT_VALUES[i]]);
-  }
+  prv_update_visible_settings();
 }
 
 static void prv_save_settings() {
-  game_settings.set_drop_shadow = MENU_INPUT_VALUES[0] % 2;
-  game_settings.set_counterclockwise = MENU_INPUT_VALUES[1] % 2;
-  game_settings.set_backlight = MENU_INPUT_VALUES[2] % 2;
-  game_settings.set_theme = MENU_INPUT_VALUES[3] % THEMES_COUNT;
+  game_settings.set_drop_shadow = MENU_INPUT_VALUES[SettingDropShadow] % 2;
+  game_settings.set_counterclockwise = MENU_INPUT_VALUES[SettingRotation] % 2;
+  game_settings.set_backlight = MENU_INPUT_VALUES[SettingBacklight] % 2;
+  game_settings.set_theme = MENU_INPUT_VALUES[SettingTheme] % THEMES_COUNT;
+  game_settings.set_das = DAS_PRESETS[MENU_INPUT_VALUES[SettingDAS]];
+  game_settings.set_arr = ARR_PRESETS[MENU_INPUT_VALUES[SettingARR]];
+  game_settings.set_soft_drop_factor = SOFT_DROP_PRESETS[MENU_INPUT_VALUES[SettingSoftDrop]];
+  game_settings.set_hard_drop = MENU_INPUT_VALUES[SettingHardDrop] % HARD_DROP_MODES;
+  game_settings.set_entry_delay = ENTRY_DELAY_PRESETS[MENU_INPUT_VALUES[SettingEntryDelay]];
+  game_settings.set_line_clear_delay = LINE_CLEAR_DELAY_PRESETS[MENU_INPUT_VALUES[SettingEntryDelay]];
+  game_settings.set_hold_input = MENU_INPUT_VALUES[SettingHold] % HOLD_INPUTS;
+  game_settings.set_game_mode = MENU_INPUT_VALUES[SettingGameMode] % GAME_MODES;
   persist_write_data(GAME_SETTINGS_KEY, &game_settings, sizeof(GameSettings));
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include <pebble.h>
 
-#define SETTINGS_COUNT 4
+#define SETTINGS_COUNT 11
+#define SETTINGS_VISIBLE 4 // rows that fit on screen, the list scrolls to show the others
+#define SETTINGS_MAX_OPTIONS 4
 
 #ifdef PBL_PLATFORM_EMERY
   #define SETTINGS_HEADER_TOP 16